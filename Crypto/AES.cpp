@@ -1,114 +1,124 @@
 #include "AES.h"
-#include <openssl/evp.h>
-#include <openssl/rand.h>
-#include <openssl/aes.h>
+#include <openssl/crypto.h>
 #include <cstring>
-#include <stdexcept>
-
-static constexpr size_t AES_BLOCK_LEN = 16;
-static constexpr size_t IV_SIZE = 16;
-static constexpr size_t KEY_SIZE_BYTES = 32;
+#include <memory>
+
+// Layout of sealed data: [nonce (12)][ciphertext][tag (16)]
+static constexpr size_t NONCE = AeadStream::NONCE_SIZE;
+static constexpr size_t TAG = AeadStream::TAG_SIZE;
+
+// One stream per thread for the key-taking calls. The last key is kept (and cleansed on
+// exit) to tell whether the schedule can be reused; a different key rekeys the same context.
+static AeadStream* streamFor(ByteSpan key) {
+    struct Holder {
+        std::unique_ptr<AeadStream> stream;
+        unsigned char key[AeadStream::KEY_SIZE] = {};
+        ~Holder() { OPENSSL_cleanse(key, sizeof(key)); }
+    };
+    thread_local Holder holder;
+    if (!holder.stream) {
+        holder.stream = std::make_unique<AeadStream>(u8(key));
+        if (!holder.stream->isValid()) {
+            holder.stream.reset();
+            return nullptr;
+        }
+    } else if (CRYPTO_memcmp(holder.key, key.data(), sizeof(holder.key)) != 0 &&
+               !holder.stream->rekey(u8(key))) {
+        holder.stream.reset();
+        return nullptr;
+    }
+    std::memcpy(holder.key, key.data(), sizeof(holder.key));
+    return holder.stream.get();
+}
 
-std::vector<unsigned char> aesEncrypt(const std::string& plaintext,
-                                      const std::vector<unsigned char>& key,
-                                      const std::vector<unsigned char>& iv) {
-    if (key.size() != KEY_SIZE_BYTES || iv.size() != IV_SIZE)
-        return {};
+size_t aesEncrypt(AeadStream& aead, ByteSpan plaintext, ByteSpan nonce, MutableByteSpan out) {
+    if (nonce.size() != NONCE) return 0;
+    const size_t needed = plaintext.size() + TAG;
+    if (out.size() < needed) return needed;
 
-    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
-    if (!ctx) return {};
+    if (!aead.seal(u8(nonce), nullptr, 0, u8(plaintext), plaintext.size(), u8(out), u8(out) + plaintext.size()))
+        return 0;
+    return needed;
+}
 
-    std::vector<unsigned char> ciphertext(plaintext.size() + AES_BLOCK_LEN);
-    int len, ciphertext_len;
+size_t aesDecryptWithEmbeddedIV(AeadStream& aead, ByteSpan data, MutableByteSpan plaintext) {
+    if (data.size() < NONCE + TAG) return 0;
+    const size_t size = data.size() - NONCE - TAG;
+    if (plaintext.size() < size) return size;
 
-    if (EVP_EncryptInit_ex(ctx, EVP_aes_256_cbc(), nullptr, key.data(), iv.data()) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
-        return {};
-    }
-    if (EVP_EncryptUpdate(ctx, ciphertext.data(), &len,
-                          reinterpret_cast<const unsigned char*>(plaintext.c_str()),
-                          static_cast<int>(plaintext.size())) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
-        return {};
-    }
-    ciphertext_len = len;
-    if (EVP_EncryptFinal_ex(ctx, ciphertext.data() + len, &len) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
-        return {};
-    }
-    ciphertext_len += len;
-    ciphertext.resize(ciphertext_len);
-    EVP_CIPHER_CTX_free(ctx);
-    return ciphertext;
+    // Decrypt straight out of `data`; no copies of the nonce or ciphertext
+    if (!aead.open(u8(data), nullptr, 0, u8(data) + NONCE, size, u8(plaintext), u8(data) + NONCE + size))
+        return 0;
+    return size;
 }
 
-std::vector<unsigned char> aesDecryptWithEmbeddedIV(const std::vector<unsigned char>& data,
-                                                     const std::vector<unsigned char>& key) {
-    if (data.size() < IV_SIZE || key.size() != KEY_SIZE_BYTES)
-        return {};
+size_t prepareAndEncrypt(AeadStream& aead, int senderId, std::span<const float> ultrasoundData, MutableByteSpan out) {
+    const size_t payloadSize = sizeof(int) + ultrasoundData.size_bytes();
+    const size_t needed = NONCE + payloadSize + TAG;
+    if (out.size() < needed) return needed;
+
+    // Assemble the payload inside the output buffer and encrypt it in place
+    unsigned char* payload = u8(out) + NONCE;
+    std::memcpy(payload, &senderId, sizeof(int));
+    if (!ultrasoundData.empty())
+        std::memcpy(payload + sizeof(int), ultrasoundData.data(), ultrasoundData.size_bytes());
+
+    if (!AeadStream::randomNonce(u8(out)) ||
+        !aead.seal(u8(out), nullptr, 0, payload, payloadSize, payload, payload + payloadSize))
+        return 0;
+    return needed;
+}
 
-    std::vector<unsigned char> iv(data.begin(), data.begin() + IV_SIZE);
-    std::vector<unsigned char> ciphertext(data.begin() + IV_SIZE, data.end());
+size_t aesEncrypt(ByteSpan plaintext, ByteSpan key, ByteSpan nonce, MutableByteSpan out) {
+    if (key.size() != AeadStream::KEY_SIZE || nonce.size() != NONCE)
+        return 0;
+    const size_t needed = plaintext.size() + TAG;
+    if (out.size() < needed) return needed;
+    AeadStream* aead = streamFor(key);
+    return aead ? aesEncrypt(*aead, plaintext, nonce, out) : 0;
+}
 
-    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
-    if (!ctx) return {};
+size_t aesDecryptWithEmbeddedIV(ByteSpan data, ByteSpan key, MutableByteSpan plaintext) {
+    if (data.size() < NONCE + TAG || key.size() != AeadStream::KEY_SIZE)
+        return 0;
+    const size_t size = data.size() - NONCE - TAG;
+    if (plaintext.size() < size) return size;
+    AeadStream* aead = streamFor(key);
+    return aead ? aesDecryptWithEmbeddedIV(*aead, data, plaintext) : 0;
+}
 
-    std::vector<unsigned char> plaintext(ciphertext.size());
-    int len, plaintext_len;
+size_t prepareAndEncrypt(int senderId, std::span<const float> ultrasoundData, ByteSpan key32, MutableByteSpan out) {
+    if (key32.size() != AeadStream::KEY_SIZE) return 0;
+    const size_t needed = NONCE + sizeof(int) + ultrasoundData.size_bytes() + TAG;
+    if (out.size() < needed) return needed;
+    AeadStream* aead = streamFor(key32);
+    return aead ? prepareAndEncrypt(*aead, senderId, ultrasoundData, out) : 0;
+}
 
-    if (EVP_DecryptInit_ex(ctx, EVP_aes_256_cbc(), nullptr, key.data(), iv.data()) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
-        return {};
-    }
-    if (EVP_DecryptUpdate(ctx, plaintext.data(), &len, ciphertext.data(),
-                          static_cast<int>(ciphertext.size())) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
+std::vector<unsigned char> aesEncrypt(const std::string& plaintext,
+                                      const std::vector<unsigned char>& key,
+                                      const std::vector<unsigned char>& iv) {
+    std::vector<unsigned char> out(plaintext.size() + TAG);
+    if (aesEncrypt(asBytes(plaintext), asBytes(key), asBytes(iv), asWritableBytes(out)) != out.size())
         return {};
-    }
-    plaintext_len = len;
-    if (EVP_DecryptFinal_ex(ctx, plaintext.data() + len, &len) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
+    return out;
+}
+
+std::vector<unsigned char> aesDecryptWithEmbeddedIV(const std::vector<unsigned char>& data,
+                                                     const std::vector<unsigned char>& key) {
+    if (data.size() < NONCE + TAG) return {};
+    std::vector<unsigned char> plaintext(data.size() - NONCE - TAG);
+    if (aesDecryptWithEmbeddedIV(asBytes(data), asBytes(key), asWritableBytes(plaintext)) != plaintext.size())
         return {};
-    }
-    plaintext_len += len;
-    plaintext.resize(plaintext_len);
-    EVP_CIPHER_CTX_free(ctx);
     return plaintext;
 }
 
 std::vector<unsigned char> prepareAndEncrypt(int senderId,
                                              const std::vector<float>& ultrasoundData,
                                              const std::vector<unsigned char>& key32) {
-    if (key32.size() != KEY_SIZE_BYTES) return {};
-
-    size_t payloadSize = sizeof(int) + ultrasoundData.size() * sizeof(float);
-    std::vector<unsigned char> plaintext(payloadSize);
-    std::memcpy(plaintext.data(), &senderId, sizeof(int));
-    std::memcpy(plaintext.data() + sizeof(int), ultrasoundData.data(),
-                ultrasoundData.size() * sizeof(float));
-
-    unsigned char iv[IV_SIZE];
-    if (RAND_bytes(iv, IV_SIZE) != 1) return {};
-
-    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
-    if (!ctx) return {};
-
-    std::vector<unsigned char> ciphertext(plaintext.size() + AES_BLOCK_LEN);
-    int len, ciphertext_len;
-
-    if (EVP_EncryptInit_ex(ctx, EVP_aes_256_cbc(), nullptr, key32.data(), iv) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
+    std::vector<unsigned char> out(NONCE + sizeof(int) + ultrasoundData.size() * sizeof(float) + TAG);
+    if (prepareAndEncrypt(senderId, std::span<const float>(ultrasoundData), asBytes(key32),
+                          asWritableBytes(out)) != out.size())
         return {};
-    }
-    EVP_EncryptUpdate(ctx, ciphertext.data(), &len, plaintext.data(), static_cast<int>(plaintext.size()));
-    ciphertext_len = len;
-    EVP_EncryptFinal_ex(ctx, ciphertext.data() + len, &len);
-    ciphertext_len += len;
-    ciphertext.resize(ciphertext_len);
-    EVP_CIPHER_CTX_free(ctx);
-
-    std::vector<unsigned char> out;
-    out.insert(out.end(), iv, iv + IV_SIZE);
-    out.insert(out.end(), ciphertext.begin(), ciphertext.end());
     return out;
 }
@@ -1,9 +1,14 @@
 #ifndef AES_HELPER_H
 #define AES_HELPER_H
 
+#include "Bytes.h"
+#include "AeadStream.h"
+#include <span>
 #include <string>
 #include <vector>
 
+// AES-256-GCM (see AeadStream). aesEncrypt takes a 12-byte nonce and returns ciphertext + tag;
+// the other two use [nonce][ciphertext][tag] and return {} when authentication fails.
 std::vector<unsigned char> aesEncrypt(const std::string& plaintext,
                                       const std::vector<unsigned char>& key,
                                       const std::vector<unsigned char>& iv);
@@ -15,4 +20,15 @@ std::vector<unsigned char> prepareAndEncrypt(int senderId,
                                             const std::vector<float>& ultrasoundData,
                                             const std::vector<unsigned char>& key32);
 
+// Same operations into caller buffers (size convention in Bytes.h)
+size_t aesEncrypt(ByteSpan plaintext, ByteSpan key, ByteSpan nonce, MutableByteSpan out);
+size_t aesDecryptWithEmbeddedIV(ByteSpan data, ByteSpan key, MutableByteSpan plaintext);
+size_t prepareAndEncrypt(int senderId, std::span<const float> ultrasoundData, ByteSpan key32, MutableByteSpan out);
+
+// Same again with a caller-owned stream, so a key used for many messages is expanded once.
+// The key-taking versions above keep one stream per thread and rekey it only when the key changes.
+size_t aesEncrypt(AeadStream& aead, ByteSpan plaintext, ByteSpan nonce, MutableByteSpan out);
+size_t aesDecryptWithEmbeddedIV(AeadStream& aead, ByteSpan data, MutableByteSpan plaintext);
+size_t prepareAndEncrypt(AeadStream& aead, int senderId, std::span<const float> ultrasoundData, MutableByteSpan out);
+
 #endif
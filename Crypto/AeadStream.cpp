@@ -0,0 +1,88 @@
+#include "AeadStream.h"
+#include <openssl/rand.h>
+#include <climits>
+
+// EVP takes int lengths; larger chunks are fed in pieces
+static constexpr size_t MAX_STEP = INT_MAX & ~size_t(15);
+
+AeadStream::AeadStream(const unsigned char* key) {
+    m_ctx = EVP_CIPHER_CTX_new();
+    if (!m_ctx) return;
+    if (EVP_CipherInit_ex(m_ctx, EVP_aes_256_gcm(), nullptr, nullptr, nullptr, 1) != 1 ||
+        EVP_CIPHER_CTX_ctrl(m_ctx, EVP_CTRL_GCM_SET_IVLEN, static_cast<int>(NONCE_SIZE), nullptr) != 1 ||
+        EVP_CipherInit_ex(m_ctx, nullptr, nullptr, key, nullptr, 1) != 1) {
+        EVP_CIPHER_CTX_free(m_ctx);
+        m_ctx = nullptr;
+    }
+}
+
+AeadStream::~AeadStream() {
+    EVP_CIPHER_CTX_free(m_ctx);     // also cleanses the key schedule
+}
+
+bool AeadStream::rekey(const unsigned char* key) {
+    return m_ctx && EVP_CipherInit_ex(m_ctx, nullptr, nullptr, key, nullptr, -1) == 1;
+}
+
+bool AeadStream::randomNonce(unsigned char* nonce) {
+    return RAND_bytes(nonce, static_cast<int>(NONCE_SIZE)) == 1;
+}
+
+// Only the nonce and direction change; the expanded key is kept (GCM encrypts the counter
+// stream in both directions)
+bool AeadStream::begin(const unsigned char* nonce, bool encrypt) {
+    if (!m_ctx) return false;
+    m_encrypting = encrypt;
+    return EVP_CipherInit_ex(m_ctx, nullptr, nullptr, nullptr, nonce, encrypt ? 1 : 0) == 1;
+}
+
+bool AeadStream::addAad(const void* data, size_t size) {
+    const auto* p = static_cast<const unsigned char*>(data);
+    int len = 0;
+    while (size > 0) {
+        size_t step = size < MAX_STEP ? size : MAX_STEP;
+        if (EVP_CipherUpdate(m_ctx, nullptr, &len, p, static_cast<int>(step)) != 1) return false;
+        p += step;
+        size -= step;
+    }
+    return true;
+}
+
+bool AeadStream::update(const unsigned char* in, size_t size, unsigned char* out) {
+    int len = 0;
+    while (size > 0) {
+        size_t step = size < MAX_STEP ? size : MAX_STEP;
+        if (EVP_CipherUpdate(m_ctx, out, &len, in, static_cast<int>(step)) != 1) return false;
+        in += step;
+        out += step;
+        size -= step;
+    }
+    return true;
+}
+
+bool AeadStream::finishEncrypt(unsigned char* tag) {
+    unsigned char unused[16];
+    int len = 0;
+    return m_encrypting &&
+           EVP_CipherFinal_ex(m_ctx, unused, &len) == 1 &&
+           EVP_CIPHER_CTX_ctrl(m_ctx, EVP_CTRL_GCM_GET_TAG, static_cast<int>(TAG_SIZE), tag) == 1;
+}
+
+bool AeadStream::finishDecrypt(const unsigned char* tag) {
+    unsigned char unused[16];
+    int len = 0;
+    return !m_encrypting &&
+           EVP_CIPHER_CTX_ctrl(m_ctx, EVP_CTRL_GCM_SET_TAG, static_cast<int>(TAG_SIZE),
+                               const_cast<unsigned char*>(tag)) == 1 &&
+           EVP_CipherFinal_ex(m_ctx, unused, &len) == 1;
+}
+
+bool AeadStream::seal(const unsigned char* nonce, const void* aad, size_t aadSize,
+                      const unsigned char* in, size_t size, unsigned char* out, unsigned char* tag) {
+    return beginEncrypt(nonce) && addAad(aad, aadSize) && update(in, size, out) && finishEncrypt(tag);
+}
+
+bool AeadStream::open(const unsigned char* nonce, const void* aad, size_t aadSize,
+                      const unsigned char* in, size_t size, unsigned char* out, const unsigned char* tag) {
+    return beginDecrypt(nonce) && addAad(aad, aadSize) && update(in, size, out) && finishDecrypt(tag);
+}
@@ -0,0 +1,50 @@
+#ifndef AEAD_STREAM_H
+#define AEAD_STREAM_H
+
+#include <openssl/evp.h>
+#include <cstddef>
+
+// AES-256-GCM with the key schedule done once per key. A message is processed as
+// begin -> addAad* -> update* -> finish, in chunks of any size, writing into caller
+// buffers (out may equal in for in-place). Every message needs its own nonce.
+// One instance per thread.
+class AeadStream {
+public:
+    static constexpr size_t KEY_SIZE = 32;
+    static constexpr size_t NONCE_SIZE = 12;
+    static constexpr size_t TAG_SIZE = 16;
+
+    explicit AeadStream(const unsigned char* key);
+    ~AeadStream();
+    AeadStream(const AeadStream&) = delete;
+    AeadStream& operator=(const AeadStream&) = delete;
+
+    bool isValid() const { return m_ctx != nullptr; }
+    // Replaces the key schedule, keeping the cipher context
+    bool rekey(const unsigned char* key);
+    static bool randomNonce(unsigned char* nonce);
+
+    bool beginEncrypt(const unsigned char* nonce) { return begin(nonce, true); }
+    bool beginDecrypt(const unsigned char* nonce) { return begin(nonce, false); }
+    // Associated data: authenticated, not encrypted. Must come before the first update().
+    bool addAad(const void* data, size_t size);
+    // Writes exactly `size` bytes to out
+    bool update(const unsigned char* in, size_t size, unsigned char* out);
+    bool finishEncrypt(unsigned char* tag);
+    // False when the ciphertext, AAD or tag was tampered with; discard the output then
+    bool finishDecrypt(const unsigned char* tag);
+
+    // Whole-message helpers
+    bool seal(const unsigned char* nonce, const void* aad, size_t aadSize,
+              const unsigned char* in, size_t size, unsigned char* out, unsigned char* tag);
+    bool open(const unsigned char* nonce, const void* aad, size_t aadSize,
+              const unsigned char* in, size_t size, unsigned char* out, const unsigned char* tag);
+
+private:
+    bool begin(const unsigned char* nonce, bool encrypt);
+
+    EVP_CIPHER_CTX* m_ctx = nullptr;
+    bool m_encrypting = false;
+};
+
+#endif
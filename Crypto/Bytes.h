@@ -0,0 +1,32 @@
+#ifndef CRYPTO_BYTES_H
+#define CRYPTO_BYTES_H
+
+#include <cstddef>
+#include <span>
+#include <string_view>
+#include <vector>
+
+// Views taken and filled by the allocation-free overloads in this library.
+// A function that fills an output span returns the size the output needs: if that is
+// <= out.size() the bytes were written; otherwise nothing was written and the call should be
+// repeated with a buffer of that size. 0 means failure.
+using ByteSpan = std::span<const std::byte>;
+using MutableByteSpan = std::span<std::byte>;
+
+inline ByteSpan asBytes(std::string_view s) {
+    return { reinterpret_cast<const std::byte*>(s.data()), s.size() };
+}
+inline ByteSpan asBytes(const std::vector<unsigned char>& v) {
+    return std::as_bytes(std::span(v));
+}
+inline MutableByteSpan asWritableBytes(std::vector<unsigned char>& v) {
+    return std::as_writable_bytes(std::span(v));
+}
+inline const unsigned char* u8(ByteSpan s) {
+    return reinterpret_cast<const unsigned char*>(s.data());
+}
+inline unsigned char* u8(MutableByteSpan s) {
+    return reinterpret_cast<unsigned char*>(s.data());
+}
+
+#endif
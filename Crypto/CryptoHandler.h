@@ -1,14 +1,33 @@
 #ifndef CRYPTO_HANDLER_H
 #define CRYPTO_HANDLER_H
 
+#include "Bytes.h"
+#include "SecureArena.h"
 #include <string>
+#include <string_view>
 #include <vector>
 
 class CryptoHandler {
 public:
-    static void generateKeyPair(std::string& pubKey, std::string& privKey);
+    static void generateKeyPair(std::string& pubKey, SecureString& privKey);
     static std::vector<unsigned char> encrypt(const std::string& plainText, const std::string& pubKey);
-    static std::string decrypt(const std::vector<unsigned char>& cipherText, const std::string& privKey);
+    static std::string decrypt(const std::vector<unsigned char>& cipherText, std::string_view privKey);
+
+    // RSA-OAEP into caller buffers (size convention in Bytes.h)
+    static size_t encrypt(ByteSpan plainText, std::string_view pubKey, MutableByteSpan cipherText);
+    static size_t decrypt(ByteSpan cipherText, std::string_view privKey, MutableByteSpan plainText);
+
+    // Hybrid encryption for payloads of any size: ephemeral X25519 agreement with the
+    // receiver's raw 32-byte public key, HKDF-SHA256, then AES-256-GCM.
+    // Ciphertext: ephemeral public key | encrypted payload | tag (HYBRID_OVERHEAD bytes extra).
+    static constexpr size_t X25519_KEY_SIZE = 32;
+    static constexpr size_t HYBRID_OVERHEAD = X25519_KEY_SIZE + 16;
+    static void generateHybridKeyPair(std::vector<unsigned char>& rawPubKey, SecureString& privKeyPem);
+    static std::vector<unsigned char> hybridEncrypt(const std::string& plainText,
+                                                    const std::vector<unsigned char>& rawPubKey);
+    static std::string hybridDecrypt(const std::vector<unsigned char>& cipherText, std::string_view privKeyPem);
+    static size_t hybridEncrypt(ByteSpan plainText, ByteSpan rawPubKey, MutableByteSpan cipherText);
+    static size_t hybridDecrypt(ByteSpan cipherText, std::string_view privKeyPem, MutableByteSpan plainText);
 };
 
 #endif
@@ -1,7 +1,14 @@
 #ifndef DIGITAL_SIGNATURE_H
 #define DIGITAL_SIGNATURE_H
 
+#include "Bytes.h"
+#include "KeyCache.h"
+#include "SecureArena.h"
+#include <openssl/evp.h>
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace DigitalSignature {
@@ -10,15 +17,84 @@ namespace DigitalSignature {
 long long getTimestampNonce();
 std::string getTimestampNonceString();  // "YYYY-MM-DD HH:MM:SS" form
 
-// ECDSA (or RSA) sign: message = e.g. "senderId|receiverId|amount|nonce"
-std::vector<unsigned char> signTransaction(const std::string& message, const std::string& privKeyPem);
+// ECDSA P-256 sign: message = e.g. "senderId|receiverId|amount|nonce"
+std::vector<unsigned char> signTransaction(const std::string& message, std::string_view privKeyPem);
+size_t signTransaction(std::string_view message, std::string_view privKeyPem, MutableByteSpan signature);
 
 bool verifySignature(const std::string& message,
                      const std::vector<unsigned char>& signature,
                      const std::string& pubKeyPem);
+bool verifySignature(std::string_view message, ByteSpan signature, std::string_view pubKeyPem);
 
-// Generate ECDSA key pair (PEM strings)
-void generateKeyPair(std::string& pubKeyPem, std::string& privKeyPem);
+// Generate ECDSA key pair (PEM strings; the private key only ever in wiped memory)
+void generateKeyPair(std::string& pubKeyPem, SecureString& privKeyPem);
+// An EC key on prime256v1; SigningKey / VerifyingKey refuse anything else (RSA, other curves)
+bool isP256Key(const EVP_PKEY* pkey);
+
+// Parsed ECDSA P-256 / SHA-256 keys for repeated use. The PEM is decoded once (through
+// KeyCache) and the digest context initialised once; each sign/verify copies that context
+// into a per-thread scratch context, so calls are safe from several threads and cost only
+// the curve arithmetic.
+class SigningKey {
+public:
+    explicit SigningKey(std::string_view privKeyPem);
+    ~SigningKey();
+    SigningKey(const SigningKey&) = delete;
+    SigningKey& operator=(const SigningKey&) = delete;
+
+    bool isValid() const { return m_ctx != nullptr; }
+    // DER signature into `signature` (see Bytes.h for the size convention)
+    size_t sign(ByteSpan message, MutableByteSpan signature) const;
+    std::vector<unsigned char> sign(const void* message, size_t size) const;
+    std::vector<unsigned char> sign(const std::string& message) const { return sign(message.data(), message.size()); }
+    std::string publicKeyPem() const;
+
+private:
+    KeyCache::KeyPtr m_pkey;
+    EVP_MD_CTX* m_ctx = nullptr;    // initialised for signing, never updated
+};
+
+class VerifyingKey {
+public:
+    explicit VerifyingKey(std::string_view pubKeyPem);
+    ~VerifyingKey();
+    VerifyingKey(const VerifyingKey&) = delete;
+    VerifyingKey& operator=(const VerifyingKey&) = delete;
+
+    bool isValid() const { return m_ctx != nullptr; }
+    bool verify(ByteSpan message, ByteSpan signature) const;
+    bool verify(const void* message, size_t size, const unsigned char* signature, size_t signatureSize) const {
+        return verify({ static_cast<const std::byte*>(message), size },
+                      { reinterpret_cast<const std::byte*>(signature), signatureSize });
+    }
+    bool verify(const std::string& message, const std::vector<unsigned char>& signature) const {
+        return verify(asBytes(message), asBytes(signature));
+    }
+
+private:
+    KeyCache::KeyPtr m_pkey;
+    EVP_MD_CTX* m_ctx = nullptr;    // initialised for verification, never updated
+};
+
+// One signature to check. Items that share a signer should point at the same PEM string;
+// each distinct key is parsed once per batch either way.
+struct VerifyItem {
+    const void* message;
+    size_t messageSize;
+    const unsigned char* signature;
+    size_t signatureSize;
+    const std::string* publicKeyPem;
+};
+
+// Verifies items[0..count) on up to `threads` threads (0 = one per core). Returns a bitmap:
+// bit (i % 64) of word (i / 64) is set when item i verified.
+std::vector<uint64_t> verifyBatch(const VerifyItem* items, size_t count, unsigned threads = 0);
+inline std::vector<uint64_t> verifyBatch(std::span<const VerifyItem> items, unsigned threads = 0) {
+    return verifyBatch(items.data(), items.size(), threads);
+}
+inline bool batchResult(const std::vector<uint64_t>& bitmap, size_t i) {
+    return (bitmap[i / 64] >> (i % 64)) & 1u;
+}
 
 } // namespace DigitalSignature
 
@@ -3,7 +3,13 @@
 #include <openssl/pem.h>
 #include <openssl/ec.h>
 #include <openssl/bio.h>
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <memory>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
 #include <sstream>
 #include <iomanip>
 
@@ -25,7 +31,7 @@ std::string getTimestampNonceString() {
     return oss.str();
 }
 
-void generateKeyPair(std::string& pubKeyPem, std::string& privKeyPem) {
+void generateKeyPair(std::string& pubKeyPem, SecureString& privKeyPem) {
     EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr);
     if (!ctx) return;
 
@@ -38,7 +44,7 @@ void generateKeyPair(std::string& pubKeyPem, std::string& privKeyPem) {
     EVP_PKEY_CTX_free(ctx);
 
     BIO* bioPub = BIO_new(BIO_s_mem());
-    BIO* bioPriv = BIO_new(BIO_s_mem());
+    BIO* bioPriv = BIO_new(BIO_s_secmem());     // buffer is cleansed when freed
     PEM_write_bio_PUBKEY(bioPub, pkey);
     PEM_write_bio_PrivateKey(bioPriv, pkey, nullptr, nullptr, 0, nullptr, nullptr);
 
@@ -54,48 +60,157 @@ void generateKeyPair(std::string& pubKeyPem, std::string& privKeyPem) {
     EVP_PKEY_free(pkey);
 }
 
-std::vector<unsigned char> signTransaction(const std::string& message, const std::string& privKeyPem) {
-    BIO* bio = BIO_new_mem_buf(privKeyPem.data(), static_cast<int>(privKeyPem.size()));
-    EVP_PKEY* pkey = PEM_read_bio_PrivateKey(bio, nullptr, nullptr, nullptr);
-    BIO_free(bio);
-    if (!pkey) return {};
+bool isP256Key(const EVP_PKEY* pkey) {
+    char group[32] = {};
+    return pkey && EVP_PKEY_get_id(pkey) == EVP_PKEY_EC &&
+           EVP_PKEY_get_group_name(pkey, group, sizeof(group), nullptr) == 1 &&
+           std::string_view(group) == "prime256v1";
+}
+
+// One digest context per thread, reused across calls; EVP_MD_CTX_copy_ex resets it first
+static EVP_MD_CTX* scratchContext() {
+    struct Holder {
+        EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+        ~Holder() { EVP_MD_CTX_free(ctx); }
+    };
+    thread_local Holder holder;
+    return holder.ctx;
+}
 
-    EVP_MD_CTX* ctx = EVP_MD_CTX_new();
-    if (!ctx) { EVP_PKEY_free(pkey); return {}; }
+SigningKey::SigningKey(std::string_view privKeyPem)
+    : m_pkey(KeyCache::instance().privateKey(privKeyPem)) {
+    if (!isP256Key(m_pkey.get())) {
+        m_pkey.reset();
+        return;
+    }
+    m_ctx = EVP_MD_CTX_new();
+    if (m_ctx && EVP_DigestSignInit(m_ctx, nullptr, EVP_sha256(), nullptr, m_pkey.get()) != 1) {
+        EVP_MD_CTX_free(m_ctx);
+        m_ctx = nullptr;
+    }
+}
 
-    std::vector<unsigned char> sig;
-    size_t sigLen = 0;
-    if (EVP_DigestSignInit(ctx, nullptr, EVP_sha256(), nullptr, pkey) != 1) goto cleanup;
-    if (EVP_DigestSignUpdate(ctx, message.data(), message.size()) != 1) goto cleanup;
-    if (EVP_DigestSignFinal(ctx, nullptr, &sigLen) != 1 || sigLen == 0) goto cleanup;
-    sig.resize(sigLen);
-    if (EVP_DigestSignFinal(ctx, sig.data(), &sigLen) != 1) { sig.clear(); goto cleanup; }
-    sig.resize(sigLen);
+SigningKey::~SigningKey() {
+    EVP_MD_CTX_free(m_ctx);
+}
 
-cleanup:
-    EVP_MD_CTX_free(ctx);
-    EVP_PKEY_free(pkey);
+size_t SigningKey::sign(ByteSpan message, MutableByteSpan signature) const {
+    if (!m_ctx) return 0;
+    // DER length varies per signature; OpenSSL wants room for the largest one
+    const size_t maxSize = static_cast<size_t>(EVP_PKEY_get_size(m_pkey.get()));
+    if (signature.size() < maxSize) return maxSize;
+
+    EVP_MD_CTX* ctx = scratchContext();
+    size_t sigLen = signature.size();
+    if (!ctx || EVP_MD_CTX_copy_ex(ctx, m_ctx) != 1 ||
+        EVP_DigestSignUpdate(ctx, message.data(), message.size()) != 1 ||
+        EVP_DigestSignFinal(ctx, u8(signature), &sigLen) != 1)
+        return 0;
+    return sigLen;
+}
+
+std::vector<unsigned char> SigningKey::sign(const void* message, size_t size) const {
+    const ByteSpan in(static_cast<const std::byte*>(message), size);
+    std::vector<unsigned char> sig(sign(in, MutableByteSpan()));
+    if (sig.empty()) return {};
+    sig.resize(sign(in, asWritableBytes(sig)));
     return sig;
 }
 
+std::string SigningKey::publicKeyPem() const {
+    if (!m_pkey) return {};
+    BIO* bio = BIO_new(BIO_s_mem());
+    std::string pem;
+    if (PEM_write_bio_PUBKEY(bio, m_pkey.get()) == 1) {
+        char* data = nullptr;
+        long len = BIO_get_mem_data(bio, &data);
+        if (data && len > 0) pem.assign(data, static_cast<size_t>(len));
+    }
+    BIO_free_all(bio);
+    return pem;
+}
+
+VerifyingKey::VerifyingKey(std::string_view pubKeyPem)
+    : m_pkey(KeyCache::instance().publicKey(pubKeyPem)) {
+    if (!isP256Key(m_pkey.get())) {
+        m_pkey.reset();
+        return;
+    }
+    m_ctx = EVP_MD_CTX_new();
+    if (m_ctx && EVP_DigestVerifyInit(m_ctx, nullptr, EVP_sha256(), nullptr, m_pkey.get()) != 1) {
+        EVP_MD_CTX_free(m_ctx);
+        m_ctx = nullptr;
+    }
+}
+
+VerifyingKey::~VerifyingKey() {
+    EVP_MD_CTX_free(m_ctx);
+}
+
+bool VerifyingKey::verify(ByteSpan message, ByteSpan signature) const {
+    EVP_MD_CTX* ctx = scratchContext();
+    if (!m_ctx || !ctx || EVP_MD_CTX_copy_ex(ctx, m_ctx) != 1) return false;
+    return EVP_DigestVerifyUpdate(ctx, message.data(), message.size()) == 1 &&
+           EVP_DigestVerifyFinal(ctx, u8(signature), signature.size()) == 1;
+}
+
+std::vector<unsigned char> signTransaction(const std::string& message, std::string_view privKeyPem) {
+    return SigningKey(privKeyPem).sign(message);
+}
+
+size_t signTransaction(std::string_view message, std::string_view privKeyPem, MutableByteSpan signature) {
+    return SigningKey(privKeyPem).sign(asBytes(message), signature);
+}
+
 bool verifySignature(const std::string& message,
                      const std::vector<unsigned char>& signature,
                      const std::string& pubKeyPem) {
-    BIO* bio = BIO_new_mem_buf(pubKeyPem.data(), static_cast<int>(pubKeyPem.size()));
-    EVP_PKEY* pkey = PEM_read_bio_PUBKEY(bio, nullptr, nullptr, nullptr);
-    BIO_free(bio);
-    if (!pkey) return false;
+    return VerifyingKey(pubKeyPem).verify(message, signature);
+}
 
-    EVP_MD_CTX* ctx = EVP_MD_CTX_new();
-    if (!ctx) { EVP_PKEY_free(pkey); return false; }
+bool verifySignature(std::string_view message, ByteSpan signature, std::string_view pubKeyPem) {
+    return VerifyingKey(pubKeyPem).verify(asBytes(message), signature);
+}
 
-    bool ok = (EVP_DigestVerifyInit(ctx, nullptr, EVP_sha256(), nullptr, pkey) == 1 &&
-              EVP_DigestVerifyUpdate(ctx, message.data(), message.size()) == 1 &&
-              EVP_DigestVerifyFinal(ctx, signature.data(), signature.size()) == 1);
+std::vector<uint64_t> verifyBatch(const VerifyItem* items, size_t count, unsigned threads) {
+    const size_t words = (count + 63) / 64;
+    std::vector<uint64_t> bitmap(words, 0);
+    if (count == 0) return bitmap;
+
+    // Parse each distinct key once; items are then resolved to a key pointer up front
+    std::unordered_map<std::string_view, std::unique_ptr<VerifyingKey>> parsed;
+    std::vector<const VerifyingKey*> keys(count, nullptr);
+    for (size_t i = 0; i < count; ++i) {
+        if (!items[i].publicKeyPem) continue;
+        std::unique_ptr<VerifyingKey>& key = parsed[*items[i].publicKeyPem];
+        if (!key) key = std::make_unique<VerifyingKey>(*items[i].publicKeyPem);
+        if (key->isValid()) keys[i] = key.get();
+    }
 
-    EVP_MD_CTX_free(ctx);
-    EVP_PKEY_free(pkey);
-    return ok;
+    // Work is handed out in 64-item blocks, so each bitmap word has a single writer
+    std::atomic<size_t> nextWord{0};
+    auto worker = [&]() {
+        for (size_t w = nextWord++; w < words; w = nextWord++) {
+            uint64_t bits = 0;
+            const size_t end = std::min(count, (w + 1) * 64);
+            for (size_t i = w * 64; i < end; ++i) {
+                const VerifyItem& item = items[i];
+                if (keys[i] && keys[i]->verify(item.message, item.messageSize, item.signature, item.signatureSize))
+                    bits |= uint64_t(1) << (i % 64);
+            }
+            bitmap[w] = bits;
+        }
+    };
+
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::min<size_t>(threads, words));
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t)
+        pool.emplace_back(worker);
+    worker();
+    for (std::thread& t : pool)
+        t.join();
+    return bitmap;
 }
 
 } // namespace DigitalSignature
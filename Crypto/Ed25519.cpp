@@ -0,0 +1,123 @@
+#include "SignatureScheme.h"
+#include <openssl/bio.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+
+namespace DigitalSignature {
+
+const char* schemeName(SchemeId id) {
+    switch (id) {
+    case SchemeId::P256: return "ecdsa-p256";
+    case SchemeId::Ed25519: return "ed25519";
+    }
+    return "unknown";
+}
+
+bool schemeOfPrivateKey(std::string_view privKeyPem, SchemeId& id) {
+    KeyCache::KeyPtr pkey = KeyCache::instance().privateKey(privKeyPem);
+    if (!pkey) return false;
+    if (EVP_PKEY_get_id(pkey.get()) == EVP_PKEY_ED25519) {
+        id = SchemeId::Ed25519;
+        return true;
+    }
+    if (isP256Key(pkey.get())) {
+        id = SchemeId::P256;
+        return true;
+    }
+    return false;
+}
+
+// Ed25519 signs in one shot (no streaming digest to copy), so each call re-initialises
+// a per-thread context instead
+static EVP_MD_CTX* scratchContext() {
+    struct Holder {
+        EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+        ~Holder() { EVP_MD_CTX_free(ctx); }
+    };
+    thread_local Holder holder;
+    EVP_MD_CTX_reset(holder.ctx);
+    return holder.ctx;
+}
+
+static std::string writePublicPem(EVP_PKEY* pkey) {
+    BIO* bio = BIO_new(BIO_s_mem());
+    std::string pem;
+    if (PEM_write_bio_PUBKEY(bio, pkey) == 1) {
+        char* data = nullptr;
+        long len = BIO_get_mem_data(bio, &data);
+        if (data && len > 0) pem.assign(data, static_cast<size_t>(len));
+    }
+    BIO_free_all(bio);
+    return pem;
+}
+
+void generateEd25519KeyPair(std::string& pubKeyPem, SecureString& privKeyPem) {
+    EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_ED25519, nullptr);
+    if (!ctx) return;
+    EVP_PKEY* pkey = nullptr;
+    if (EVP_PKEY_keygen_init(ctx) != 1 || EVP_PKEY_keygen(ctx, &pkey) != 1) {
+        EVP_PKEY_CTX_free(ctx);
+        return;
+    }
+    EVP_PKEY_CTX_free(ctx);
+
+    pubKeyPem = writePublicPem(pkey);
+    BIO* bio = BIO_new(BIO_s_secmem());
+    PEM_write_bio_PrivateKey(bio, pkey, nullptr, nullptr, 0, nullptr, nullptr);
+    char* data = nullptr;
+    long len = BIO_get_mem_data(bio, &data);
+    if (data && len > 0) privKeyPem.assign(data, static_cast<size_t>(len));
+    BIO_free_all(bio);
+    EVP_PKEY_free(pkey);
+}
+
+Ed25519SigningKey::Ed25519SigningKey(std::string_view privKeyPem)
+    : m_pkey(KeyCache::instance().privateKey(privKeyPem)) {
+    if (m_pkey && EVP_PKEY_get_id(m_pkey.get()) != EVP_PKEY_ED25519)
+        m_pkey.reset();
+}
+
+size_t Ed25519SigningKey::sign(ByteSpan message, MutableByteSpan signature) const {
+    if (!m_pkey) return 0;
+    if (signature.size() < Ed25519::maxSignatureSize) return Ed25519::maxSignatureSize;
+    EVP_MD_CTX* ctx = scratchContext();
+    size_t sigLen = signature.size();
+    if (!ctx || EVP_DigestSignInit(ctx, nullptr, nullptr, nullptr, m_pkey.get()) != 1 ||
+        EVP_DigestSign(ctx, u8(signature), &sigLen, u8(message), message.size()) != 1)
+        return 0;
+    return sigLen;
+}
+
+std::vector<unsigned char> Ed25519SigningKey::sign(const void* message, size_t size) const {
+    std::vector<unsigned char> sig(Ed25519::maxSignatureSize);
+    sig.resize(sign({ static_cast<const std::byte*>(message), size }, asWritableBytes(sig)));
+    return sig;
+}
+
+std::string Ed25519SigningKey::publicKeyPem() const {
+    return m_pkey ? writePublicPem(m_pkey.get()) : std::string();
+}
+
+Ed25519VerifyingKey::Ed25519VerifyingKey(std::string_view pubKeyPem)
+    : m_pkey(KeyCache::instance().publicKey(pubKeyPem)) {
+    if (m_pkey && EVP_PKEY_get_id(m_pkey.get()) != EVP_PKEY_ED25519)
+        m_pkey.reset();
+}
+
+bool Ed25519VerifyingKey::verify(ByteSpan message, ByteSpan signature) const {
+    EVP_MD_CTX* ctx = scratchContext();
+    if (!m_pkey || !ctx) return false;
+    return EVP_DigestVerifyInit(ctx, nullptr, nullptr, nullptr, m_pkey.get()) == 1 &&
+           EVP_DigestVerify(ctx, u8(signature), signature.size(), u8(message), message.size()) == 1;
+}
+
+std::vector<unsigned char> Ed25519VerifyingKey::rawPublicKey() const {
+    if (!m_pkey) return {};
+    std::vector<unsigned char> raw(32);
+    size_t len = raw.size();
+    if (EVP_PKEY_get_raw_public_key(m_pkey.get(), raw.data(), &len) != 1) return {};
+    raw.resize(len);
+    return raw;
+}
+
+} // namespace DigitalSignature
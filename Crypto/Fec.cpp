@@ -0,0 +1,422 @@
+#include "Fec.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <climits>
+#include <numeric>
+
+namespace Ultrasound {
+namespace Fec {
+
+// GF(256) with the polynomial x^8 + x^4 + x^3 + x^2 + 1; exp is doubled so products skip the mod
+struct Gf {
+    std::array<uint8_t, 512> exp{};
+    std::array<uint8_t, 256> log{};
+};
+
+static const Gf& gf() {
+    static const Gf table = [] {
+        Gf t;
+        unsigned x = 1;
+        for (int i = 0; i < 255; ++i) {
+            t.exp[size_t(i)] = uint8_t(x);
+            t.log[x] = uint8_t(i);
+            x <<= 1;
+            if (x & 0x100) x ^= 0x11D;
+        }
+        for (int i = 255; i < 512; ++i) t.exp[size_t(i)] = t.exp[size_t(i - 255)];
+        return t;
+    }();
+    return table;
+}
+
+static uint8_t gfMul(uint8_t a, uint8_t b) {
+    if (a == 0 || b == 0) return 0;
+    const Gf& t = gf();
+    return t.exp[size_t(t.log[a]) + t.log[b]];
+}
+
+static uint8_t gfDiv(uint8_t a, uint8_t b) {
+    if (a == 0) return 0;
+    const Gf& t = gf();
+    return t.exp[size_t(t.log[a]) + 255 - t.log[b]];
+}
+
+static uint8_t gfAlpha(size_t power) { return gf().exp[power % 255]; }
+
+// Low degree first
+static uint8_t evaluate(const uint8_t* poly, size_t size, uint8_t x) {
+    uint8_t y = 0;
+    for (size_t i = size; i-- > 0;) y = gfMul(y, x) ^ poly[i];
+    return y;
+}
+
+ReedSolomon::ReedSolomon(size_t parity) {
+    // Roots alpha^0 .. alpha^(parity - 1)
+    m_generator.assign(1, 1);
+    for (size_t i = 0; i < parity; ++i) {
+        const uint8_t root = gfAlpha(i);
+        m_generator.push_back(0);
+        for (size_t j = m_generator.size() - 1; j > 0; --j)
+            m_generator[j] ^= gfMul(m_generator[j - 1], root);
+    }
+}
+
+void ReedSolomon::encode(const uint8_t* data, size_t size, uint8_t* parityOut) const {
+    const size_t p = parity();
+    std::fill(parityOut, parityOut + p, uint8_t(0));
+    for (size_t i = 0; i < size; ++i) {
+        const uint8_t f = data[i] ^ parityOut[0];
+        std::copy(parityOut + 1, parityOut + p, parityOut);
+        parityOut[p - 1] = 0;
+        if (f == 0) continue;
+        for (size_t j = 0; j < p; ++j) parityOut[j] ^= gfMul(f, m_generator[j + 1]);
+    }
+}
+
+int ReedSolomon::decode(uint8_t* codeword, size_t n) const {
+    const size_t p = parity();
+    if (n > 255 || n < p) return -1;
+
+    // Codeword byte i is the coefficient of x^(n - 1 - i)
+    std::array<uint8_t, 255> syndrome{};
+    bool clean = true;
+    for (size_t j = 0; j < p; ++j) {
+        const uint8_t x = gfAlpha(j);
+        uint8_t s = 0;
+        for (size_t i = 0; i < n; ++i) s = gfMul(s, x) ^ codeword[i];
+        syndrome[j] = s;
+        clean &= s == 0;
+    }
+    if (clean) return 0;
+
+    // Berlekamp-Massey: error locator lambda, low degree first, with roots at the inverse error locations
+    std::array<uint8_t, 256> lambda{}, prev{}, temp{};
+    lambda[0] = prev[0] = 1;
+    size_t errors = 0, shift = 1;
+    uint8_t prevDiscrepancy = 1;
+    for (size_t r = 0; r < p; ++r) {
+        uint8_t d = syndrome[r];
+        for (size_t i = 1; i <= errors; ++i) d ^= gfMul(lambda[i], syndrome[r - i]);
+        if (d == 0) {
+            ++shift;
+            continue;
+        }
+        const uint8_t coef = gfDiv(d, prevDiscrepancy);
+        temp = lambda;
+        for (size_t i = 0; i + shift <= p; ++i) lambda[i + shift] ^= gfMul(coef, prev[i]);
+        if (2 * errors <= r) {
+            errors = r + 1 - errors;
+            prev = temp;
+            prevDiscrepancy = d;
+            shift = 1;
+        } else {
+            ++shift;
+        }
+    }
+    if (2 * errors > p) return -1;
+
+    // Chien search over the positions the (possibly shortened) codeword actually has
+    std::array<size_t, 128> positions{};
+    size_t found = 0;
+    for (size_t i = 0; i < n && found <= errors; ++i) {
+        const size_t power = n - 1 - i;
+        if (evaluate(lambda.data(), errors + 1, gfAlpha(255 - power)) != 0) continue;
+        if (found == errors) return -1;
+        positions[found++] = i;
+    }
+    if (found != errors) return -1;
+
+    // Forney, first root alpha^0: magnitude = X * omega(1/X) / lambda'(1/X)
+    std::array<uint8_t, 256> omega{};
+    for (size_t i = 0; i < p; ++i)
+        for (size_t j = 0; j <= errors && i + j < p; ++j)
+            omega[i + j] ^= gfMul(syndrome[i], lambda[j]);
+    std::array<uint8_t, 256> derivative{};
+    for (size_t i = 1; i <= errors; i += 2) derivative[i - 1] = lambda[i];
+    for (size_t k = 0; k < found; ++k) {
+        const size_t power = n - 1 - positions[k];
+        const uint8_t inverse = gfAlpha(255 - power);
+        const uint8_t denom = evaluate(derivative.data(), errors, inverse);
+        if (denom == 0) return -1;
+        codeword[positions[k]] ^= gfMul(gfAlpha(power), gfDiv(evaluate(omega.data(), p, inverse), denom));
+    }
+
+    // More errors than the code can see may still land on a wrong codeword; catch what we can
+    for (size_t j = 0; j < p; ++j) {
+        const uint8_t x = gfAlpha(j);
+        uint8_t s = 0;
+        for (size_t i = 0; i < n; ++i) s = gfMul(s, x) ^ codeword[i];
+        if (s != 0) return -1;
+    }
+    return int(found);
+}
+
+// K = 7 convolutional code, generators 171 and 133 octal. The register holds the newest input
+// bit at the bottom; the state is its low six bits.
+static constexpr int CONSTRAINT = 7;
+static constexpr size_t TAIL_BITS = CONSTRAINT - 1;
+static constexpr unsigned STATES = 1u << TAIL_BITS;
+static constexpr unsigned POLY_A = 0171;
+static constexpr unsigned POLY_B = 0133;
+
+// Two output bits per register value: A in bit 1, B in bit 0
+static const std::array<uint8_t, 2 * STATES>& branchOutputs() {
+    static const std::array<uint8_t, 2 * STATES> table = [] {
+        std::array<uint8_t, 2 * STATES> t{};
+        for (unsigned reg = 0; reg < 2 * STATES; ++reg) {
+            const unsigned a = unsigned(std::popcount(reg & POLY_A)) & 1;
+            const unsigned b = unsigned(std::popcount(reg & POLY_B)) & 1;
+            t[reg] = uint8_t(a << 1 | b);
+        }
+        return t;
+    }();
+    return table;
+}
+
+// Which of A and B are sent at each step of the puncturing period (the usual DVB patterns)
+struct Puncture {
+    size_t period;
+    std::array<bool, 3> a;
+    std::array<bool, 3> b;
+};
+
+static Puncture puncture(CodeRate rate) {
+    switch (rate) {
+    case CodeRate::TwoThirds: return {2, {true, false, false}, {true, true, false}};
+    case CodeRate::ThreeQuarters: return {3, {true, false, true}, {true, true, false}};
+    case CodeRate::Half: break;
+    }
+    return {1, {true, false, false}, {true, false, false}};
+}
+
+static size_t codedBits(size_t steps, CodeRate rate) {
+    const Puncture p = puncture(rate);
+    size_t perPeriod = 0;
+    for (size_t i = 0; i < p.period; ++i) perPeriod += size_t(p.a[i]) + size_t(p.b[i]);
+    size_t bits = steps / p.period * perPeriod;
+    for (size_t i = 0; i < steps % p.period; ++i) bits += size_t(p.a[i]) + size_t(p.b[i]);
+    return bits;
+}
+
+static size_t symbolsFor(size_t bytes, CodeRate rate) {
+    const size_t coded = codedBits(bytes * 8 + TAIL_BITS, rate);
+    return (coded + SOFT_BITS_PER_SYMBOL - 1) / SOFT_BITS_PER_SYMBOL;
+}
+
+// Coded bit j goes to bit j / symbolCount of symbol (j % symbolCount) * step, step coprime to
+// symbolCount and near its golden section: neighbours in the trellis land far apart, and so
+// do the bits a burst of neighbouring symbols carries
+static size_t spreadStep(size_t symbolCount) {
+    size_t step = size_t(double(symbolCount) * 0.6180339887 + 0.5);
+    while (std::gcd(step, symbolCount) != 1) ++step;
+    return step;
+}
+
+// XORed onto every symbol from the header on, so long runs in the payload (zero padding, say)
+// don't keep sending the same tones, which a receiver would take for an interferer
+static uint8_t whitening(size_t symbol) {
+    uint32_t x = uint32_t(symbol + 1) * 0x9E3779B1u;
+    x ^= x >> 15;
+    x *= 0x2C1B3C6Du;
+    x ^= x >> 12;
+    return uint8_t(x >> 24);
+}
+
+// Convolutionally codes bytes (most significant bit first) and spreads the coded bits over
+// symbolCount symbols, the first of them firstSymbol in the frame
+static void encodeBits(const uint8_t* bytes, size_t count, CodeRate rate, size_t firstSymbol, size_t symbolCount,
+                       uint8_t* symbols) {
+    const std::array<uint8_t, 2 * STATES>& outputs = branchOutputs();
+    const Puncture p = puncture(rate);
+    std::fill(symbols, symbols + symbolCount, uint8_t(0));
+    const size_t steps = count * 8 + TAIL_BITS;
+    const size_t spread = spreadStep(symbolCount);
+    unsigned state = 0;
+    size_t j = 0;
+    auto put = [&](unsigned bit) {
+        symbols[(j % symbolCount) * spread % symbolCount] |= uint8_t(bit << (j / symbolCount));
+        ++j;
+    };
+    for (size_t t = 0; t < steps; ++t) {
+        const unsigned bit = t < count * 8 ? (bytes[t / 8] >> (7 - t % 8)) & 1 : 0;
+        const unsigned reg = (state << 1 | bit) & (2 * STATES - 1);
+        state = reg & (STATES - 1);
+        const size_t phase = t % p.period;
+        if (p.a[phase]) put(outputs[reg] >> 1);
+        if (p.b[phase]) put(outputs[reg] & 1);
+    }
+    for (size_t i = 0; i < symbolCount; ++i) symbols[i] ^= whitening(firstSymbol + i);
+}
+
+// Header: length (2 bytes, little endian), rate, then its own RS parity
+static constexpr size_t HEADER_DATA = 3;
+static constexpr size_t HEADER_PARITY = 4;
+static constexpr size_t HEADER_BYTES = HEADER_DATA + HEADER_PARITY;
+static_assert(HEADER_BYTES * 8 + TAIL_BITS <= HEADER_SYMBOLS * SOFT_BITS_PER_SYMBOL / 2,
+              "header must fit HEADER_SYMBOLS at rate 1/2");
+
+static size_t blockCount(size_t payloadSize) {
+    return std::max<size_t>(1, (payloadSize + RS_MAX_DATA - 1) / RS_MAX_DATA);
+}
+
+// Data bytes of RS block b: the payload is shared out as evenly as it goes
+static size_t blockData(size_t payloadSize, size_t blocks, size_t b) {
+    return payloadSize / blocks + (b < payloadSize % blocks ? 1 : 0);
+}
+
+bool isValidRate(CodeRate rate) {
+    return rate == CodeRate::Half || rate == CodeRate::TwoThirds || rate == CodeRate::ThreeQuarters;
+}
+
+size_t bodySymbols(size_t payloadSize, CodeRate rate) {
+    return symbolsFor(payloadSize + blockCount(payloadSize) * RS_PARITY, rate);
+}
+
+std::vector<uint8_t> encodeFrame(const uint8_t* payload, size_t size, CodeRate rate) {
+    const size_t body = bodySymbols(size, rate);
+    std::vector<uint8_t> symbols(HEADER_SYMBOLS + body);
+
+    uint8_t header[HEADER_BYTES] = {uint8_t(size & 0xFF), uint8_t(size >> 8), uint8_t(rate)};
+    ReedSolomon(HEADER_PARITY).encode(header, HEADER_DATA, header + HEADER_DATA);
+    encodeBits(header, HEADER_BYTES, CodeRate::Half, 0, HEADER_SYMBOLS, symbols.data());
+
+    // Codewords back to back, then sent byte 0 of each, byte 1 of each, ...
+    const size_t blocks = blockCount(size);
+    const ReedSolomon rs(RS_PARITY);
+    std::vector<uint8_t> codewords(size + blocks * RS_PARITY);
+    std::vector<size_t> offsets(blocks + 1, 0);
+    const uint8_t* data = payload;
+    for (size_t b = 0; b < blocks; ++b) {
+        const size_t n = blockData(size, blocks, b);
+        uint8_t* cw = codewords.data() + offsets[b];
+        std::copy(data, data + n, cw);
+        rs.encode(cw, n, cw + n);
+        data += n;
+        offsets[b + 1] = offsets[b] + n + RS_PARITY;
+    }
+    std::vector<uint8_t> interleaved;
+    interleaved.reserve(codewords.size());
+    for (size_t i = 0; interleaved.size() < codewords.size(); ++i)
+        for (size_t b = 0; b < blocks; ++b)
+            if (offsets[b] + i < offsets[b + 1]) interleaved.push_back(codewords[offsets[b] + i]);
+
+    encodeBits(interleaved.data(), interleaved.size(), rate, HEADER_SYMBOLS, body, symbols.data() + HEADER_SYMBOLS);
+    return symbols;
+}
+
+FrameDecoder::FrameDecoder(size_t maxPayload)
+    : m_maxPayload(std::min<size_t>(maxPayload, 0xFFFF))
+    , m_rs(RS_PARITY)
+    , m_headerRs(HEADER_PARITY) {
+    const size_t bytes = m_maxPayload + blockCount(m_maxPayload) * RS_PARITY;
+    const size_t steps = bytes * 8 + TAIL_BITS;
+    m_coded.resize(2 * steps);
+    m_decisions.resize(steps);
+    m_bits.resize(steps);
+    m_bytes.resize(bytes);
+    m_codeword.resize(bytes);
+}
+
+size_t FrameDecoder::maxBodySoftBits() const {
+    return bodySymbols(m_maxPayload, CodeRate::Half) * SOFT_BITS_PER_SYMBOL;
+}
+
+// Undoes encodeBits() into m_bytes with a soft-decision Viterbi decoder
+static void decodeBits(const SoftBit* soft, size_t count, CodeRate rate, size_t firstSymbol, size_t symbolCount,
+                       SoftBit* coded, uint64_t* decisions, uint8_t* bits, uint8_t* bytes) {
+    const std::array<uint8_t, 2 * STATES>& outputs = branchOutputs();
+    const Puncture p = puncture(rate);
+    const size_t steps = count * 8 + TAIL_BITS;
+
+    // Punctured bits come back as erasures
+    const size_t spread = spreadStep(symbolCount);
+    size_t j = 0;
+    auto take = [&]() {
+        const size_t symbol = (j % symbolCount) * spread % symbolCount, bit = j / symbolCount;
+        const SoftBit s = soft[symbol * SOFT_BITS_PER_SYMBOL + bit];
+        ++j;
+        return (whitening(firstSymbol + symbol) >> bit) & 1 ? SoftBit(-s) : s;
+    };
+    for (size_t t = 0; t < steps; ++t) {
+        const size_t phase = t % p.period;
+        coded[2 * t] = p.a[phase] ? take() : 0;
+        coded[2 * t + 1] = p.b[phase] ? take() : 0;
+    }
+
+    // Path metrics: agreement with the soft bits, larger is better; the encoder starts in state 0
+    std::array<int32_t, STATES> metric, next;
+    metric.fill(INT32_MIN / 2);
+    metric[0] = 0;
+    for (size_t t = 0; t < steps; ++t) {
+        const int32_t a = coded[2 * t], b = coded[2 * t + 1];
+        const int32_t branch[4] = {a + b, a - b, -a + b, -a - b};
+        uint64_t chosen = 0;
+        for (unsigned s = 0; s < STATES; ++s) {
+            // Predecessors differ only in the bit about to leave the register
+            const unsigned from0 = s >> 1, from1 = from0 | (STATES >> 1);
+            const unsigned bit = s & 1;
+            const int32_t m0 = metric[from0] + branch[outputs[from0 << 1 | bit]];
+            const int32_t m1 = metric[from1] + branch[outputs[from1 << 1 | bit]];
+            next[s] = std::max(m0, m1);
+            chosen |= uint64_t(m1 > m0) << s;
+        }
+        decisions[t] = chosen;
+        metric = next;
+    }
+
+    // The tail drives the encoder back to state 0
+    unsigned state = 0;
+    for (size_t t = steps; t-- > 0;) {
+        bits[t] = uint8_t(state & 1);
+        state = (state >> 1) | unsigned((decisions[t] >> state) & 1) << (TAIL_BITS - 1);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        uint8_t v = 0;
+        for (size_t k = 0; k < 8; ++k) v = uint8_t(v << 1 | bits[i * 8 + k]);
+        bytes[i] = v;
+    }
+}
+
+bool FrameDecoder::decodeHeader(const SoftBit* soft, Header& header) {
+    decodeBits(soft, HEADER_BYTES, CodeRate::Half, 0, HEADER_SYMBOLS,
+               m_coded.data(), m_decisions.data(), m_bits.data(), m_bytes.data());
+    if (m_headerRs.decode(m_bytes.data(), HEADER_BYTES) < 0) return false;
+    const size_t length = size_t(m_bytes[0]) | size_t(m_bytes[1]) << 8;
+    const CodeRate rate = CodeRate(m_bytes[2]);
+    if (length > m_maxPayload || !isValidRate(rate)) return false;
+    header.length = length;
+    header.rate = rate;
+    return true;
+}
+
+int FrameDecoder::decodeBody(const SoftBit* soft, const Header& header, uint8_t* payload) {
+    const size_t size = header.length;
+    if (size > m_maxPayload || !isValidRate(header.rate)) return -1;
+    const size_t blocks = blockCount(size);
+    const size_t total = size + blocks * RS_PARITY;
+    decodeBits(soft, total, header.rate, HEADER_SYMBOLS, bodySymbols(size, header.rate),
+               m_coded.data(), m_decisions.data(), m_bits.data(), m_bytes.data());
+
+    // Gather each codeword back together, as encodeFrame() laid them out
+    const size_t base = size / blocks, extra = size % blocks;
+    auto offset = [&](size_t b) { return b * (base + RS_PARITY) + std::min(b, extra); };
+    size_t at = 0;
+    for (size_t i = 0; at < total; ++i)
+        for (size_t b = 0; b < blocks; ++b)
+            if (offset(b) + i < offset(b + 1)) m_codeword[offset(b) + i] = m_bytes[at++];
+
+    int corrected = 0;
+    for (size_t b = 0; b < blocks; ++b) {
+        const size_t n = blockData(size, blocks, b);
+        uint8_t* cw = m_codeword.data() + offset(b);
+        const int fixed = m_rs.decode(cw, n + RS_PARITY);
+        if (fixed < 0) return -1;
+        corrected += fixed;
+        payload = std::copy(cw, cw + n, payload);
+    }
+    return corrected;
+}
+
+} // namespace Fec
+} // namespace Ultrasound
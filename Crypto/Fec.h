@@ -0,0 +1,96 @@
+#ifndef FEC_H
+#define FEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Ultrasound {
+
+// Forward error correction for the ultrasound link, one byte per modem symbol.
+//
+// Body: payload split into Reed-Solomon codewords (RS_PARITY bytes each, so up to
+// RS_PARITY / 2 wrong bytes fixed per codeword), the codewords' bytes interleaved, then a
+// K=7 convolutional code punctured to the chosen rate. The coded bits are spread across the
+// symbols with a stride, so one lost symbol costs the Viterbi decoder isolated bits rather
+// than a burst; what the Viterbi decoder still gets wrong comes out in short bursts, which the
+// byte interleaving spreads over the RS codewords.
+// Header: length and rate, with its own short RS code, always at rate 1/2; HEADER_SYMBOLS long.
+// Every symbol is XORed with a fixed pseudo-random sequence, so the tones stay evenly used
+// whatever the payload.
+namespace Fec {
+
+enum class CodeRate : uint8_t {
+    Half = 1,
+    TwoThirds = 2,
+    ThreeQuarters = 3,
+};
+
+inline constexpr size_t RS_PARITY = 32;
+inline constexpr size_t RS_MAX_DATA = 255 - RS_PARITY;
+inline constexpr size_t HEADER_SYMBOLS = 16;
+inline constexpr CodeRate DEFAULT_RATE = CodeRate::TwoThirds;
+
+// Soft decision on a coded bit: positive leans to 0, negative to 1, 0 says nothing
+using SoftBit = int8_t;
+inline constexpr size_t SOFT_BITS_PER_SYMBOL = 8;
+
+// Systematic Reed-Solomon over GF(256), shortened to any codeword length up to 255
+class ReedSolomon {
+public:
+    explicit ReedSolomon(size_t parity);
+
+    size_t parity() const { return m_generator.size() - 1; }
+
+    // Writes parity() bytes that follow data in the codeword
+    void encode(const uint8_t* data, size_t size, uint8_t* parityOut) const;
+    // codeword = data followed by its parity, n <= 255 bytes. Fixes it in place and returns
+    // the bytes corrected, or -1 when there are more errors than the code can fix.
+    int decode(uint8_t* codeword, size_t n) const;
+
+private:
+    std::vector<uint8_t> m_generator;   // highest degree first
+};
+
+struct Header {
+    size_t length = 0;
+    CodeRate rate = DEFAULT_RATE;
+};
+
+bool isValidRate(CodeRate rate);
+// Body symbols for a payload of that size
+size_t bodySymbols(size_t payloadSize, CodeRate rate);
+// Header then body, one byte per modem symbol
+std::vector<uint8_t> encodeFrame(const uint8_t* payload, size_t size, CodeRate rate);
+
+// Scratch space is sized once for maxPayload at the lowest rate, so decoding never allocates
+class FrameDecoder {
+public:
+    explicit FrameDecoder(size_t maxPayload);
+
+    size_t maxPayload() const { return m_maxPayload; }
+    // Most soft bits a frame's body can need
+    size_t maxBodySoftBits() const;
+
+    // HEADER_SYMBOLS * SOFT_BITS_PER_SYMBOL soft bits. False when it doesn't decode or
+    // announces more than maxPayload.
+    bool decodeHeader(const SoftBit* soft, Header& header);
+    // bodySymbols() * SOFT_BITS_PER_SYMBOL soft bits; writes header.length bytes. Returns the
+    // bytes the RS code had to correct, or -1 when a codeword was beyond repair.
+    int decodeBody(const SoftBit* soft, const Header& header, uint8_t* payload);
+
+private:
+    size_t m_maxPayload;
+    ReedSolomon m_rs;
+    ReedSolomon m_headerRs;
+    std::vector<SoftBit> m_coded;       // de-interleaved, de-punctured: two per trellis step
+    std::vector<uint64_t> m_decisions;  // Viterbi survivor bits, one word per trellis step
+    std::vector<uint8_t> m_bits;
+    std::vector<uint8_t> m_bytes;
+    std::vector<uint8_t> m_codeword;
+};
+
+} // namespace Fec
+} // namespace Ultrasound
+
+#endif
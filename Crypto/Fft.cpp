@@ -0,0 +1,46 @@
+#include "Fft.h"
+#include <cmath>
+#include <utility>
+
+Fft::Fft(size_t n)
+    : m_n(n) {
+    m_twiddle.resize(n / 2);
+    for (size_t k = 0; k < n / 2; ++k) {
+        const double a = -2.0 * 3.14159265358979323846 * double(k) / double(n);
+        m_twiddle[k] = Complex(float(std::cos(a)), float(std::sin(a)));
+    }
+    size_t bits = 0;
+    while ((size_t(1) << bits) < n) ++bits;
+    for (size_t i = 0; i < n; ++i) {
+        size_t r = 0;
+        for (size_t b = 0; b < bits; ++b)
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        if (i < r) {
+            m_swaps.push_back(i);
+            m_swaps.push_back(r);
+        }
+    }
+}
+
+// Plain product: std::complex's operator* checks for inf/NaN on every multiply
+static inline Fft::Complex mul(Fft::Complex a, Fft::Complex b) {
+    return { a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real() };
+}
+
+void Fft::transform(Complex* data, bool inverse) const {
+    for (size_t i = 0; i < m_swaps.size(); i += 2)
+        std::swap(data[m_swaps[i]], data[m_swaps[i + 1]]);
+
+    for (size_t len = 2; len <= m_n; len <<= 1) {
+        const size_t half = len / 2;
+        const size_t stride = m_n / len;
+        for (size_t start = 0; start < m_n; start += len) {
+            for (size_t k = 0; k < half; ++k) {
+                const Complex w = inverse ? std::conj(m_twiddle[k * stride]) : m_twiddle[k * stride];
+                const Complex t = mul(w, data[start + k + half]);
+                data[start + k + half] = data[start + k] - t;
+                data[start + k] += t;
+            }
+        }
+    }
+}
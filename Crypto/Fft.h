@@ -0,0 +1,31 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+// In-place iterative radix-2 FFT with the twiddles and bit-reversal order computed once per
+// size. transform() doesn't allocate, so one instance can be reused from an audio thread.
+class Fft {
+public:
+    using Complex = std::complex<float>;
+
+    // n must be a power of two
+    explicit Fft(size_t n);
+
+    size_t size() const { return m_n; }
+
+    void forward(Complex* data) const { transform(data, false); }
+    // Unscaled: forward() then inverse() multiplies by size()
+    void inverse(Complex* data) const { transform(data, true); }
+
+private:
+    void transform(Complex* data, bool inverse) const;
+
+    size_t m_n;
+    std::vector<Complex> m_twiddle;     // e^(-2 pi i k / n), k < n / 2
+    std::vector<size_t> m_swaps;        // bit-reversal pairs, flattened
+};
+
+#endif
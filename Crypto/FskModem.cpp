@@ -0,0 +1,527 @@
+#include "FskModem.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace Ultrasound {
+
+static constexpr double PI = 3.14159265358979323846;
+static constexpr int SINE_TABLE_SIZE = 1 << FskModulator::SINE_TABLE_BITS;
+static constexpr int PHASE_SHIFT = 32 - FskModulator::SINE_TABLE_BITS;
+
+static const float* sineTable() {
+    static const std::vector<float> table = [] {
+        std::vector<float> t(SINE_TABLE_SIZE);
+        for (int i = 0; i < SINE_TABLE_SIZE; ++i)
+            t[size_t(i)] = float(std::sin(2.0 * PI * i / SINE_TABLE_SIZE));
+        return t;
+    }();
+    return table.data();
+}
+
+static constexpr int16_t SILENT_SYMBOL = -1;
+static constexpr int16_t PREAMBLE_SYMBOL = -2;
+
+static constexpr int grayCode(int nibble) { return nibble ^ (nibble >> 1); }
+
+// Nibble each tone stands for
+static constexpr std::array<uint8_t, TONES_PER_NIBBLE> TONE_VALUE = [] {
+    std::array<uint8_t, TONES_PER_NIBBLE> t{};
+    for (int v = 0; v < TONES_PER_NIBBLE; ++v) t[size_t(grayCode(v))] = uint8_t(v);
+    return t;
+}();
+
+// Analytic chirp across the band with raised-cosine edges; the modulator sends its real part
+static void makeChirp(const ModemParams& params, bool up, Fft::Complex* out) {
+    const int n = params.chirpSamples();
+    const int ramp = params.rampSamples;
+    const double fs = params.sampleRate;
+    const double f0 = up ? params.chirpLowHz() : params.chirpHighHz();
+    const double f1 = up ? params.chirpHighHz() : params.chirpLowHz();
+    for (int i = 0; i < n; ++i) {
+        double w = 1.0;
+        if (i < ramp) w = 0.5 - 0.5 * std::cos(PI * (i + 0.5) / ramp);
+        else if (i >= n - ramp) w = 0.5 - 0.5 * std::cos(PI * (n - i - 0.5) / ramp);
+        const double phase = 2.0 * PI * (f0 * i / fs + (f1 - f0) * double(i) * i / (2.0 * n * fs));
+        out[i] = Fft::Complex(float(w * std::cos(phase)), float(w * std::sin(phase)));
+    }
+}
+
+ModemParams ModemParams::forSampleRate(int sampleRate) {
+    ModemParams p;
+    if (sampleRate <= 0) return p;
+    p.analysisSamples = int(std::lround(sampleRate * ANALYSIS_SECONDS));
+    p.rampSamples = (int(std::lround(sampleRate * SYMBOL_SECONDS)) - p.analysisSamples) / 2;
+    p.symbolSamples = p.analysisSamples + 2 * p.rampSamples;
+    p.binHz = double(sampleRate) / p.analysisSamples;
+    p.firstBin = int(std::lround(CARRIER_LOW_HZ / p.binHz));
+    p.sampleRate = sampleRate;
+    // Keep a bin of headroom below Nyquist for the anti-aliasing filter's roll-off
+    if (p.toneHz(TONE_COUNT - 1) > sampleRate / 2.0 - p.binHz)
+        return ModemParams();
+    return p;
+}
+
+FskModulator::FskModulator(const ModemParams& params)
+    : m_params(params) {
+    if (!params.isValid()) return;
+    m_envelope.assign(size_t(params.symbolSamples), 1.0f);
+    const int ramp = params.rampSamples;
+    for (int i = 0; i < ramp; ++i) {
+        const float rise = float(0.5 - 0.5 * std::cos(PI * (i + 0.5) / ramp));
+        m_envelope[size_t(i)] = rise;
+        m_envelope[size_t(params.symbolSamples - 1 - i)] = rise;
+    }
+    for (int t = 0; t < TONE_COUNT; ++t)
+        m_step[size_t(t)] = uint32_t(std::llround(params.toneHz(t) / params.sampleRate * 4294967296.0));
+    sineTable();
+
+    // Same peak level as two tones
+    const size_t chirp = size_t(params.chirpSamples());
+    std::vector<Fft::Complex> shape(chirp);
+    m_preamble.resize(2 * chirp);
+    for (int half = 0; half < 2; ++half) {
+        makeChirp(params, half == 0, shape.data());
+        for (size_t i = 0; i < chirp; ++i)
+            m_preamble[half * chirp + i] = 2 * AMPLITUDE * shape[i].real();
+    }
+}
+
+bool FskModulator::setPayload(const unsigned char* data, size_t size, bool repeat, Fec::CodeRate rate) {
+    if (!m_params.isValid() || size > MAX_FRAME_PAYLOAD || !Fec::isValidRate(rate)) return false;
+    const std::vector<uint8_t> coded = Fec::encodeFrame(data, size, rate);
+    m_frame.clear();
+    m_frame.reserve(PREAMBLE_SYMBOLS + coded.size() + GAP_SYMBOLS);
+    m_frame.insert(m_frame.end(), PREAMBLE_SYMBOLS, PREAMBLE_SYMBOL);
+    for (uint8_t value : coded)
+        m_frame.push_back(int16_t(grayCode(value & 0x0F) | grayCode(value >> 4) << 4));
+    m_frame.insert(m_frame.end(), GAP_SYMBOLS, SILENT_SYMBOL);
+    m_repeat = repeat;
+    rewind();
+    return true;
+}
+
+void FskModulator::rewind() {
+    m_symbol = 0;
+    m_sample = 0;
+    m_phaseLow = m_phaseHigh = 0;
+}
+
+size_t FskModulator::render(float* out, size_t frames) {
+    const float* sine = sineTable();
+    size_t written = 0;
+    while (written < frames) {
+        if (m_symbol >= m_frame.size()) {
+            if (!m_repeat || m_frame.empty()) break;
+            m_symbol = 0;
+        }
+        // Whatever is left of the current symbol, in one tight loop
+        const size_t n = std::min(frames - written, size_t(m_params.symbolSamples - m_sample));
+        const int16_t value = m_frame[m_symbol];
+        float* dst = out + written;
+        if (value == SILENT_SYMBOL) {
+            std::fill(dst, dst + n, 0.0f);
+        } else if (value == PREAMBLE_SYMBOL) {
+            // The preamble opens the frame, so the symbol index is also its offset
+            const float* src = m_preamble.data() + m_symbol * size_t(m_params.symbolSamples) + size_t(m_sample);
+            std::copy(src, src + n, dst);
+        } else {
+            const uint32_t stepLow = m_step[size_t(value & 0x0F)];
+            const uint32_t stepHigh = m_step[size_t(TONES_PER_NIBBLE + (value >> 4))];
+            const float* env = m_envelope.data() + m_sample;
+            uint32_t low = m_phaseLow, high = m_phaseHigh;
+            for (size_t i = 0; i < n; ++i) {
+                dst[i] = AMPLITUDE * env[i] * (sine[low >> PHASE_SHIFT] + sine[high >> PHASE_SHIFT]);
+                low += stepLow;
+                high += stepHigh;
+            }
+            m_phaseLow = low;
+            m_phaseHigh = high;
+        }
+        written += n;
+        m_sample += int(n);
+        if (m_sample == m_params.symbolSamples) {
+            // The envelope is zero at the edges, so each symbol may start from phase 0
+            m_sample = 0;
+            m_phaseLow = m_phaseHigh = 0;
+            ++m_symbol;
+        }
+    }
+    return written;
+}
+
+size_t FskModulator::render(int16_t* out, size_t frames) {
+    float chunk[256];
+    size_t written = 0;
+    while (written < frames) {
+        const size_t want = std::min(frames - written, sizeof(chunk) / sizeof(chunk[0]));
+        const size_t got = render(chunk, want);
+        for (size_t i = 0; i < got; ++i)
+            out[written + i] = int16_t(std::lrint(chunk[i] * 32767.0f));
+        written += got;
+        if (got < want) break;
+    }
+    return written;
+}
+
+// Correlating against a C-sample template, a block of 2C or more keeps the overlap below half
+static size_t correlatorSize(const ModemParams& params) {
+    size_t n = 1;
+    if (params.isValid())
+        while (n < 2 * size_t(params.chirpSamples())) n <<= 1;
+    return n;
+}
+
+// Vertex of the parabola through the magnitudes either side of a peak, in samples from it
+static double peakOffset(float before, float at, float after) {
+    const double a = std::sqrt(before), b = std::sqrt(at), c = std::sqrt(after);
+    const double denom = a - 2 * b + c;
+    return denom < 0 ? 0.5 * (a - c) / denom : 0.0;
+}
+
+ChirpDetector::ChirpDetector(const ModemParams& params)
+    : m_params(params)
+    , m_fft(correlatorSize(params)) {
+    if (!params.isValid()) return;
+    const size_t m = m_fft.size();
+    m_chirp = size_t(params.chirpSamples());
+    m_block = m - m_chirp + 1;
+    m_maxShift = size_t(std::ceil(MAX_OFFSET_HZ * m_chirp / (params.chirpHighHz() - params.chirpLowHz())));
+
+    // Convolving with the reversed conjugate template correlates; 1/m folds in the inverse
+    // transform's scaling
+    std::vector<Fft::Complex> shape(m_chirp);
+    for (int half = 0; half < 2; ++half) {
+        std::vector<Fft::Complex>& filter = half == 0 ? m_upFilter : m_downFilter;
+        makeChirp(params, half == 0, shape.data());
+        filter.assign(m, Fft::Complex());
+        for (size_t i = 0; i < m_chirp; ++i)
+            filter[i] = std::conj(shape[m_chirp - 1 - i]) / float(m);
+        m_fft.forward(filter.data());
+    }
+    m_spectrum.resize(m);
+    m_work.resize(m);
+    m_input.resize(m);
+    m_upPower.resize(4 * m);
+    m_downPower.resize(4 * m);
+    m_ringMask = 4 * m - 1;
+    reset();
+}
+
+void ChirpDetector::reset() {
+    std::fill(m_input.begin(), m_input.end(), 0.0f);
+    std::fill(m_upPower.begin(), m_upPower.end(), 0.0f);
+    std::fill(m_downPower.begin(), m_downPower.end(), 0.0f);
+    m_fill = m_chirp > 0 ? m_chirp - 1 : 0;
+    m_count = 0;
+    m_noiseFloor = 0;
+    m_haveCandidate = false;
+}
+
+bool ChirpDetector::push(float sample, Hit& hit) {
+    if (m_input.empty()) return false;
+    m_input[m_fill++] = sample;
+    ++m_count;
+    if (m_fill < m_input.size()) return false;
+    const bool found = processBlock(hit);
+    std::copy(m_input.end() - ptrdiff_t(m_chirp - 1), m_input.end(), m_input.begin());
+    m_fill = m_chirp - 1;
+    return found;
+}
+
+bool ChirpDetector::processBlock(Hit& hit) {
+    const size_t m = m_fft.size();
+    for (size_t i = 0; i < m; ++i)
+        m_spectrum[i] = Fft::Complex(m_input[i], 0.0f);
+    m_fft.forward(m_spectrum.data());
+
+    // Output i is the correlation window ending at m_input[i]; the first C - 1 wrap around
+    const uint64_t base = m_count - m;
+    double sum = 0;
+    for (int half = 0; half < 2; ++half) {
+        const std::vector<Fft::Complex>& filter = half == 0 ? m_upFilter : m_downFilter;
+        std::vector<float>& ring = half == 0 ? m_upPower : m_downPower;
+        for (size_t k = 0; k < m; ++k) {
+            const Fft::Complex a = m_spectrum[k], b = filter[k];
+            m_work[k] = Fft::Complex(a.real() * b.real() - a.imag() * b.imag(),
+                                     a.real() * b.imag() + a.imag() * b.real());
+        }
+        m_fft.inverse(m_work.data());
+        for (size_t i = m_chirp - 1; i < m; ++i) {
+            const float p = std::norm(m_work[i]);
+            ring[size_t(base + i) & m_ringMask] = p;
+            sum += p;
+        }
+    }
+    const float mean = float(sum / double(2 * m_block));
+    if (m_noiseFloor <= 0) m_noiseFloor = mean;
+    const float threshold = DETECT_RATIO * std::max(m_noiseFloor, 1e-20f);
+
+    const uint64_t reach = m_chirp + 2 * m_maxShift;
+    for (uint64_t j = base + m_chirp - 1; j < m_count; ++j) {
+        const float down = downPower(j);
+        if (down < threshold || j < reach) continue;
+        if (m_haveCandidate && down <= downPower(m_candidateDown)) continue;
+        // The up chirp's peak sits a chirp length earlier, give or take the offset shift
+        uint64_t best = j - reach;
+        for (uint64_t u = best + 1; u <= j - m_chirp + 2 * m_maxShift; ++u)
+            if (upPower(u) > upPower(best)) best = u;
+        if (upPower(best) < threshold) continue;
+        m_haveCandidate = true;
+        m_candidateDown = j;
+        m_candidateUp = best;
+        m_candidateStrength = std::min(down, upPower(best)) / std::max(m_noiseFloor, 1e-20f);
+    }
+    m_noiseFloor = 0.9f * m_noiseFloor + 0.1f * mean;
+
+    // Confirmed once a whole chirp length after the peak has been seen without a stronger one
+    if (m_haveCandidate && m_count - 1 >= m_candidateDown + m_chirp)
+        return confirm(hit);
+    return false;
+}
+
+bool ChirpDetector::confirm(Hit& hit) {
+    m_haveCandidate = false;
+    // A real preamble correlates to a narrow spike; a steady tone in the band to a plateau
+    for (int half = 0; half < 2; ++half) {
+        const uint64_t peak = half == 0 ? m_candidateUp : m_candidateDown;
+        const float at = half == 0 ? upPower(peak) : downPower(peak);
+        double sum = 0;
+        for (uint64_t i = peak - m_chirp; i <= peak + m_chirp; ++i)
+            sum += half == 0 ? upPower(i) : downPower(i);
+        if (at < PEAK_RATIO * float(sum / double(2 * m_chirp + 1))) return false;
+    }
+
+    const double up = double(m_candidateUp)
+                      + peakOffset(upPower(m_candidateUp - 1), upPower(m_candidateUp), upPower(m_candidateUp + 1));
+    const double down = double(m_candidateDown)
+                        + peakOffset(downPower(m_candidateDown - 1), downPower(m_candidateDown), downPower(m_candidateDown + 1));
+    // A scale error e (Doppler, clock mismatch) moves every frequency by e * centre, which
+    // pulls the up peak earlier and pushes the down peak later by e * gain samples, and it
+    // shortens each chirp by e * C, which moves both peaks by half that. Solve the peaks'
+    // spacing for e, then step from the down peak to the end of the preamble.
+    const double c = double(m_chirp);
+    const double gain = m_params.centreHz() * c / (m_params.chirpHighHz() - m_params.chirpLowHz());
+    const double scale = (down - up - c) / (2 * gain - c);
+    hit.position = down + 1 - scale * (gain + c / 2);
+    hit.frequencyOffsetHz = scale * m_params.centreHz();
+    hit.strength = m_candidateStrength;
+    return true;
+}
+
+static constexpr double SDFT_DAMPING = 0.9999;
+
+FskDemodulator::FskDemodulator(const ModemParams& params, size_t maxPayload, FrameHandler onFrame)
+    : m_params(params)
+    , m_maxPayload(std::min(maxPayload, MAX_FRAME_PAYLOAD))
+    , m_onFrame(std::move(onFrame))
+    , m_detector(params)
+    , m_decoder(m_maxPayload) {
+    if (!params.isValid()) return;
+    // Enough for the detector to report a preamble before the sliding DFT reaches its start
+    m_delay.resize(m_detector.latency() + (PREAMBLE_SYMBOLS + 1) * size_t(params.symbolSamples));
+    m_history.resize(size_t(params.analysisSamples));
+    m_soft.resize(Fec::HEADER_SYMBOLS * Fec::SOFT_BITS_PER_SYMBOL + m_decoder.maxBodySoftBits());
+    m_payload.reserve(m_maxPayload);
+    reset();
+}
+
+void FskDemodulator::reset() {
+    m_detector.reset();
+    std::fill(m_delay.begin(), m_delay.end(), 0.0f);
+    m_delayPos = 0;
+    m_count = 0;
+    m_hasPending = false;
+    m_state = State::Searching;
+}
+
+void FskDemodulator::process(const float* samples, size_t frames, size_t stride) {
+    if (!m_params.isValid()) return;
+    // Work on local copies so the bin loop can't alias the input and vectorizes across bins
+    Bins re = m_re, im = m_im;
+    Bins rotRe = m_rotRe, rotIm = m_rotIm, oldRe = m_oldRe, oldIm = m_oldIm;
+    const size_t n = m_history.size();
+    for (size_t i = 0; i < frames; ++i) {
+        const float x = samples[i * stride];
+        ChirpDetector::Hit hit;
+        if (m_detector.push(x, hit)) {
+            m_pending = hit;
+            m_hasPending = true;
+            m_pendingStart = hit.position - double(PREAMBLE_SYMBOLS * size_t(m_params.symbolSamples))
+                                                / (1.0 + hit.frequencyOffsetHz / m_params.centreHz());
+        }
+        const float delayed = m_delay[m_delayPos];
+        m_delay[m_delayPos] = x;
+        if (++m_delayPos == m_delay.size()) m_delayPos = 0;
+        const int64_t at = int64_t(m_count++) - int64_t(m_delay.size());
+
+        if (m_hasPending && double(at) >= m_pendingStart - 1) {
+            // Frames never overlap, so one still running here was locked onto noise
+            if (m_state != State::Searching) ++m_framesDropped;
+            m_hasPending = false;
+            lock(m_pending);
+            re.fill(0.0f);
+            im.fill(0.0f);
+            rotRe = m_rotRe;
+            rotIm = m_rotIm;
+            oldRe = m_oldRe;
+            oldIm = m_oldIm;
+        }
+        if (m_state == State::Searching) continue;
+
+        const float old = m_history[m_historyPos];
+        m_history[m_historyPos] = delayed;
+        if (++m_historyPos == n) m_historyPos = 0;
+        for (size_t k = 0; k < size_t(TONE_COUNT); ++k) {
+            const float r = re[k] * rotRe[k] - im[k] * rotIm[k] + delayed - old * oldRe[k];
+            im[k] = re[k] * rotIm[k] + im[k] * rotRe[k] - old * oldIm[k];
+            re[k] = r;
+        }
+
+        if (at >= m_nextDecision) {
+            measure(re, im);
+            if (m_symbolIndex >= 0) {
+                decide(m_soft.data() + size_t(m_symbolIndex) * Fec::SOFT_BITS_PER_SYMBOL);
+                onSymbol();
+            }
+            if (m_state != State::Searching) {
+                ++m_symbolIndex;
+                scheduleDecision();
+            }
+        }
+    }
+    m_re = re;
+    m_im = im;
+}
+
+void FskDemodulator::process(const int16_t* samples, size_t frames, size_t stride) {
+    float chunk[256];
+    while (frames > 0) {
+        const size_t n = std::min(frames, sizeof(chunk) / sizeof(chunk[0]));
+        for (size_t i = 0; i < n; ++i)
+            chunk[i] = samples[i * stride] * (1.0f / 32768.0f);
+        process(chunk, n);
+        samples += n * stride;
+        frames -= n;
+    }
+}
+
+void FskDemodulator::measure(const Bins& re, const Bins& im) {
+    for (size_t k = 0; k < size_t(TONE_COUNT); ++k)
+        m_power[k] = re[k] * re[k] + im[k] * im[k];
+    if (m_symbolIndex < 0) {
+        for (size_t k = 0; k < size_t(TONE_COUNT); ++k)
+            m_preambleBackground[k] = std::min(m_preambleBackground[k], m_power[k]);
+        return;
+    }
+    m_recentPos = (m_recentPos + 1) % BACKGROUND_SYMBOLS;
+    m_recentPower[m_recentPos] = m_power;
+}
+
+void FskDemodulator::decide(Fec::SoftBit* soft) const {
+    const Bins& power = m_power;
+    Bins recent = power;
+    for (const Bins& past : m_recentPower)
+        for (size_t k = 0; k < size_t(TONE_COUNT); ++k)
+            recent[k] = std::min(recent[k], past[k]);
+    Bins background;
+    for (size_t k = 0; k < size_t(TONE_COUNT); ++k)
+        background[k] = std::max(m_preambleBackground[k], recent[k]);
+
+    // Max-log soft bits on amplitudes in noise units, which is what a non-coherent detector's
+    // likelihood grows with
+    for (int half = 0; half < 2; ++half) {
+        const size_t first = size_t(half * TONES_PER_NIBBLE);
+        std::array<float, TONES_PER_NIBBLE> sorted;
+        std::copy(power.begin() + ptrdiff_t(first), power.begin() + ptrdiff_t(first + TONES_PER_NIBBLE), sorted.begin());
+        std::nth_element(sorted.begin(), sorted.begin() + TONES_PER_NIBBLE / 2, sorted.end());
+        const float median = std::max(sorted[TONES_PER_NIBBLE / 2], 1e-20f);
+
+        std::array<float, TONES_PER_NIBBLE> amplitude;
+        for (size_t t = 0; t < size_t(TONES_PER_NIBBLE); ++t)
+            amplitude[t] = std::sqrt(power[first + t] / std::max(background[first + t], median));
+        for (int bit = 0; bit < 4; ++bit) {
+            float clear = 0, set = 0;
+            for (size_t t = 0; t < size_t(TONES_PER_NIBBLE); ++t) {
+                float& side = (TONE_VALUE[t] >> bit) & 1 ? set : clear;
+                side = std::max(side, amplitude[t]);
+            }
+            const float llr = std::clamp(SOFT_SCALE * (clear - set), -127.0f, 127.0f);
+            soft[4 * half + bit] = Fec::SoftBit(std::lrint(llr));
+        }
+    }
+}
+
+void FskDemodulator::lock(const ChirpDetector::Hit& hit) {
+    m_preamble = hit;
+    // Doppler and clock error scale every frequency, and the symbol clock inversely, alike
+    const double ratio = 1.0 + hit.frequencyOffsetHz / m_params.centreHz();
+    m_symbolScale = 1.0 / ratio;
+    const int n = m_params.analysisSamples;
+    const double decay = std::pow(SDFT_DAMPING, n);
+    for (int t = 0; t < TONE_COUNT; ++t) {
+        const double w = 2.0 * PI * m_params.toneHz(t) * ratio / m_params.sampleRate;
+        m_rotRe[size_t(t)] = float(SDFT_DAMPING * std::cos(w));
+        m_rotIm[size_t(t)] = float(SDFT_DAMPING * std::sin(w));
+        m_oldRe[size_t(t)] = float(decay * std::cos(w * n));
+        m_oldIm[size_t(t)] = float(decay * std::sin(w * n));
+    }
+    std::fill(m_history.begin(), m_history.end(), 0.0f);
+    m_historyPos = 0;
+    // Until BACKGROUND_SYMBOLS data symbols are in, only the preamble speaks for the background
+    m_preambleBackground.fill(std::numeric_limits<float>::max());
+    for (Bins& recent : m_recentPower) recent.fill(0.0f);
+    m_recentPos = 0;
+
+    m_state = State::Header;
+    m_symbolIndex = -int64_t(PREAMBLE_SYMBOLS);
+    m_frameSymbols = Fec::HEADER_SYMBOLS;
+    scheduleDecision();
+}
+
+void FskDemodulator::scheduleDecision() {
+    // Last sample of the symbol's analysis window, as sent, then stretched to the receiver's clock
+    const double sent = double(m_params.rampSamples + m_params.analysisSamples - 1)
+                        + double(m_symbolIndex) * m_params.symbolSamples;
+    m_nextDecision = int64_t(std::llround(m_preamble.position + m_symbolScale * sent));
+}
+
+void FskDemodulator::onSymbol() {
+    if (size_t(m_symbolIndex) + 1 < m_frameSymbols) return;
+
+    if (m_state == State::Header) {
+        // Also what tells a real preamble from a false lock
+        if (!m_decoder.decodeHeader(m_soft.data(), m_header)) {
+            dropFrame();
+            return;
+        }
+        m_state = State::Body;
+        m_frameSymbols = Fec::HEADER_SYMBOLS + Fec::bodySymbols(m_header.length, m_header.rate);
+        return;
+    }
+
+    m_payload.resize(m_header.length);
+    const int corrected = m_decoder.decodeBody(m_soft.data() + Fec::HEADER_SYMBOLS * Fec::SOFT_BITS_PER_SYMBOL,
+                                               m_header, m_payload.data());
+    if (corrected < 0) {
+        dropFrame();
+        return;
+    }
+    m_bytesCorrected += uint64_t(corrected);
+    finishFrame();
+}
+
+void FskDemodulator::dropFrame() {
+    ++m_framesDropped;
+    m_state = State::Searching;
+}
+
+void FskDemodulator::finishFrame() {
+    ++m_framesDecoded;
+    m_state = State::Searching;
+    if (m_onFrame) m_onFrame(m_payload.data(), m_payload.size());
+}
+
+} // namespace Ultrasound
@@ -0,0 +1,246 @@
+#ifndef FSK_MODEM_H
+#define FSK_MODEM_H
+
+#include "Fec.h"
+#include "Fft.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace Ultrasound {
+
+// Near-ultrasound multi-tone FSK. Each 10 ms symbol carries one byte as two simultaneous
+// tones: the low nibble picks one of 16 tones in the lower half of 18-22 kHz, the high
+// nibble one of 16 in the upper half, Gray coded so mistaking a tone for its neighbour costs
+// one bit. Tones sit on exact bins of the 8 ms analysis window in the middle of the symbol,
+// so they are orthogonal there; the 1 ms at either end is a raised-cosine ramp that keeps
+// the symbol edges from clicking into the audible band.
+//
+// Frame: PREAMBLE | FEC header | FEC-coded payload | GAP_SYMBOLS of silence (see Fec.h)
+// The preamble is a linear chirp sweeping the whole band up, then straight back down, each
+// half two symbols long.
+inline constexpr double CARRIER_LOW_HZ = 18000.0;
+inline constexpr int TONES_PER_NIBBLE = 16;
+inline constexpr int TONE_COUNT = 2 * TONES_PER_NIBBLE;
+inline constexpr double SYMBOL_SECONDS = 0.010;
+inline constexpr double ANALYSIS_SECONDS = 0.008;
+inline constexpr size_t CHIRP_SYMBOLS = 2;
+inline constexpr size_t PREAMBLE_SYMBOLS = 2 * CHIRP_SYMBOLS;
+inline constexpr size_t FRAME_HEADER_SYMBOLS = PREAMBLE_SYMBOLS + Fec::HEADER_SYMBOLS;
+inline constexpr size_t GAP_SYMBOLS = 10;
+inline constexpr size_t MAX_FRAME_PAYLOAD = 0xFFFF;
+
+struct ModemParams {
+    int sampleRate = 0;
+    int symbolSamples = 0;
+    int analysisSamples = 0;
+    int rampSamples = 0;        // raised-cosine edge on each side of the analysis window
+    int firstBin = 0;           // tone t is at bin firstBin + t of the analysis window
+    double binHz = 0;
+
+    // Invalid (isValid() false) when the rate cannot carry the top tone, i.e. below ~44.1 kHz
+    static ModemParams forSampleRate(int sampleRate);
+    bool isValid() const { return sampleRate > 0; }
+    double toneHz(int tone) const { return (firstBin + tone) * binHz; }
+
+    int chirpSamples() const { return int(CHIRP_SYMBOLS) * symbolSamples; }
+    double chirpLowHz() const { return toneHz(0) - binHz / 2; }
+    double chirpHighHz() const { return toneHz(TONE_COUNT - 1) + binHz / 2; }
+    double centreHz() const { return (chirpLowHz() + chirpHighHz()) / 2; }
+};
+
+// Streams the frame as audio samples, repeating it (with the silent gap) until told
+// otherwise so a listener can start at any point. Synthesis runs from a sine table and one
+// phase accumulator per tone, the preamble from a table built once; render() never allocates.
+class FskModulator {
+public:
+    explicit FskModulator(const ModemParams& params);
+
+    const ModemParams& params() const { return m_params; }
+
+    // Allocates; call before streaming, not from the audio callback. False when too long.
+    bool setPayload(const unsigned char* data, size_t size, bool repeat = true,
+                    Fec::CodeRate rate = Fec::DEFAULT_RATE);
+    void rewind();
+
+    // Mono samples; returns how many were written, fewer than asked only once a
+    // non-repeating frame has ended
+    size_t render(float* out, size_t frames);
+    size_t render(int16_t* out, size_t frames);
+
+    bool finished() const { return !m_repeat && m_symbol >= m_frame.size(); }
+    size_t frameSymbols() const { return m_frame.size(); }
+    double frameSeconds() const { return double(m_frame.size() * size_t(m_params.symbolSamples)) / m_params.sampleRate; }
+
+    static constexpr float AMPLITUDE = 0.45f;   // per tone; two tones peak at 0.9
+    static constexpr int SINE_TABLE_BITS = 12;
+
+private:
+    ModemParams m_params;
+    std::vector<float> m_envelope;              // one symbol: ramp up, flat, ramp down
+    std::vector<float> m_preamble;
+    std::array<uint32_t, TONE_COUNT> m_step{};  // phase increment per sample, 2^32 = one cycle
+    std::vector<int16_t> m_frame;               // byte per symbol, negative for preamble or silence
+    size_t m_symbol = 0;
+    int m_sample = 0;                           // position inside the current symbol
+    uint32_t m_phaseLow = 0;
+    uint32_t m_phaseHigh = 0;
+    bool m_repeat = true;
+};
+
+// Finds the frame preamble in a sample stream by overlap-save FFT correlation against both
+// chirps: one forward and two inverse FFTs per block. A carrier offset (Doppler, or the two
+// sound cards' clocks disagreeing) shifts the up and down chirp's peaks in opposite
+// directions, so the midpoint of the pair gives the timing and their spacing the offset.
+// Each peak is refined to a fraction of a sample by a parabola through its neighbours. A
+// preamble counts once both peaks stand well clear of the correlator's running noise floor,
+// which only sees in-band noise, and of their own surroundings, and no stronger one follows
+// within a chirp length.
+class ChirpDetector {
+public:
+    struct Hit {
+        double position = 0;            // stream index (samples pushed) where the first data symbol starts
+        double frequencyOffsetHz = 0;   // received minus sent, at the centre of the band
+        float strength = 0;             // weaker peak's power over the noise floor
+    };
+
+    explicit ChirpDetector(const ModemParams& params);
+
+    void reset();
+    // True when this sample completed a block in which a preamble was confirmed
+    bool push(float sample, Hit& hit);
+
+    // Most samples that can follow a preamble's end before push() reports it
+    size_t latency() const { return m_fft.size() + m_maxShift + 1; }
+
+    static constexpr float DETECT_RATIO = 20.0f;    // peak power over the running noise floor
+    static constexpr float PEAK_RATIO = 12.0f;      // peak power over the mean within a chirp length of it
+    static constexpr double MAX_OFFSET_HZ = 200.0;
+
+private:
+    bool processBlock(Hit& hit);
+    bool confirm(Hit& hit);
+    float upPower(uint64_t index) const { return m_upPower[size_t(index) & m_ringMask]; }
+    float downPower(uint64_t index) const { return m_downPower[size_t(index) & m_ringMask]; }
+
+    ModemParams m_params;
+    Fft m_fft;
+    size_t m_chirp = 0;                         // C, template length
+    size_t m_block = 0;                         // new samples per FFT: size - C + 1
+    size_t m_maxShift = 0;                      // peak shift at MAX_OFFSET_HZ
+    std::vector<Fft::Complex> m_upFilter;       // spectra of the time-reversed conjugate chirps
+    std::vector<Fft::Complex> m_downFilter;
+    std::vector<Fft::Complex> m_spectrum;
+    std::vector<Fft::Complex> m_work;
+    std::vector<float> m_input;                 // C - 1 samples of overlap, then the new block
+    size_t m_fill = 0;
+    uint64_t m_count = 0;                       // samples pushed
+
+    // |correlation|^2 by the stream index the correlation window ends at
+    std::vector<float> m_upPower;
+    std::vector<float> m_downPower;
+    size_t m_ringMask = 0;
+    float m_noiseFloor = 0;
+
+    bool m_haveCandidate = false;               // strongest down peak not yet confirmed
+    uint64_t m_candidateDown = 0;
+    uint64_t m_candidateUp = 0;
+    float m_candidateStrength = 0;
+};
+
+// Streaming receiver for FskModulator frames. The chirp detector runs on the newest samples;
+// a sliding DFT tracking all 32 tone bins runs a fixed delay behind it, so by the time it
+// reaches a frame the preamble has already fixed where every symbol's analysis window lies
+// and how far the tones have shifted. The bins are retuned by that offset and the symbol
+// clock stretched to match, then each symbol becomes eight soft bits for the FEC decoder:
+// how far the strongest tone with the bit clear stands above the strongest with it set,
+// against the noise. Each bin is measured against the larger of the symbol's median bin and
+// its own background, so a steady in-band whistle reads as noise instead of as a confident
+// tone. The background is the bin's least power over the preamble, which leaves any single
+// bin nearly dark, or over the last BACKGROUND_SYMBOLS data symbols for one that starts
+// mid-frame. A header that doesn't decode drops the lock. State carries across process()
+// calls, the footprint is fixed at construction, and the handler runs as soon as the last
+// payload symbol is in and the frame corrects.
+class FskDemodulator {
+public:
+    using FrameHandler = std::function<void(const unsigned char* data, size_t size)>;
+
+    // Frames announcing more than maxPayload bytes are taken for noise and dropped
+    FskDemodulator(const ModemParams& params, size_t maxPayload, FrameHandler onFrame);
+
+    const ModemParams& params() const { return m_params; }
+
+    void reset();
+    // stride is the distance between consecutive samples, i.e. the channel count when
+    // listening to the first channel of interleaved audio
+    void process(const float* samples, size_t frames, size_t stride = 1);
+    void process(const int16_t* samples, size_t frames, size_t stride = 1);
+
+    bool locked() const { return m_state != State::Searching; }
+    uint64_t framesDecoded() const { return m_framesDecoded; }
+    uint64_t framesDropped() const { return m_framesDropped; }
+    // Payload bytes the Reed-Solomon code has fixed in the frames decoded so far
+    uint64_t bytesCorrected() const { return m_bytesCorrected; }
+    // Timing and carrier offset of the most recent preamble
+    const ChirpDetector::Hit& lastPreamble() const { return m_preamble; }
+
+    static constexpr float SOFT_SCALE = 16.0f;          // soft bit per tone amplitude gap, in noise amplitudes
+    static constexpr size_t BACKGROUND_SYMBOLS = 16;    // a bin lit this long is an interferer, not data
+
+private:
+    using Bins = std::array<float, TONE_COUNT>;
+
+    void measure(const Bins& re, const Bins& im);
+    void decide(Fec::SoftBit* soft) const;
+    void lock(const ChirpDetector::Hit& hit);
+    void scheduleDecision();
+    void onSymbol();
+    void dropFrame();
+    void finishFrame();
+
+    enum class State { Searching, Header, Body };
+
+    ModemParams m_params;
+    size_t m_maxPayload;
+    FrameHandler m_onFrame;
+    ChirpDetector m_detector;
+    Fec::FrameDecoder m_decoder;
+
+    std::vector<float> m_delay;                 // the sliding DFT runs m_delay.size() samples behind
+    size_t m_delayPos = 0;
+    uint64_t m_count = 0;                       // samples pushed
+
+    // Sliding DFT: X = r e^(jw) X + x[n] - r^N e^(jwN) x[n-N]; r < 1 keeps float error from
+    // piling up, and the e^(jwN) term lets the bins sit off the analysis grid after retuning
+    Bins m_re{}, m_im{};
+    Bins m_rotRe{}, m_rotIm{};
+    Bins m_oldRe{}, m_oldIm{};
+    std::vector<float> m_history;               // last N samples
+    size_t m_historyPos = 0;
+
+    State m_state = State::Searching;
+    ChirpDetector::Hit m_pending;               // reported, but the sliding DFT hasn't got there yet
+    bool m_hasPending = false;
+    double m_pendingStart = 0;                  // where its preamble starts
+    ChirpDetector::Hit m_preamble;
+    double m_symbolScale = 1;                   // received samples per sent sample
+    int64_t m_symbolIndex = 0;                  // data symbols decided in this frame, negative in the preamble
+    int64_t m_nextDecision = 0;                 // delayed-stream index of the next window's last sample
+    Bins m_power{};                             // of the symbol just measured
+    Bins m_preambleBackground{};
+    std::array<Bins, BACKGROUND_SYMBOLS> m_recentPower{};  // data symbols', newest at m_recentPos
+    size_t m_recentPos = 0;
+    std::vector<Fec::SoftBit> m_soft;           // header then body, SOFT_BITS_PER_SYMBOL per symbol
+    Fec::Header m_header;
+    size_t m_frameSymbols = 0;                  // header and body, once the header has decoded
+    std::vector<unsigned char> m_payload;
+    uint64_t m_framesDecoded = 0;
+    uint64_t m_framesDropped = 0;
+    uint64_t m_bytesCorrected = 0;
+};
+
+} // namespace Ultrasound
+
+#endif
@@ -0,0 +1,147 @@
+#include "CryptoHandler.h"
+#include "AeadStream.h"
+#include "KeyCache.h"
+#include <openssl/bio.h>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/kdf.h>
+#include <openssl/pem.h>
+#include <array>
+#include <cstring>
+
+static_assert(CryptoHandler::HYBRID_OVERHEAD == CryptoHandler::X25519_KEY_SIZE + AeadStream::TAG_SIZE);
+
+static const char HKDF_LABEL[] = "FastPay hybrid v1";
+
+namespace {
+using RawKey = std::array<unsigned char, CryptoHandler::X25519_KEY_SIZE>;
+// The derived key is used for exactly one message, so the nonce can come from HKDF as well
+using MessageKey = std::array<unsigned char, AeadStream::KEY_SIZE + AeadStream::NONCE_SIZE>;
+}
+
+// HKDF-SHA256 over the shared secret, bound to both public keys so a ciphertext cannot be
+// replayed against another recipient or with a swapped ephemeral key
+static bool deriveMessageKey(EVP_PKEY* own, EVP_PKEY* peer, const RawKey& ephemeral,
+                             const RawKey& recipient, MessageKey& out) {
+    unsigned char shared[CryptoHandler::X25519_KEY_SIZE];
+    size_t sharedLen = sizeof(shared);
+    EVP_PKEY_CTX* dh = EVP_PKEY_CTX_new(own, nullptr);
+    // OpenSSL rejects the all-zero result a small-order peer key would produce
+    bool ok = dh && EVP_PKEY_derive_init(dh) == 1 && EVP_PKEY_derive_set_peer(dh, peer) == 1 &&
+              EVP_PKEY_derive(dh, shared, &sharedLen) == 1;
+    EVP_PKEY_CTX_free(dh);
+
+    unsigned char info[sizeof(HKDF_LABEL) + 2 * CryptoHandler::X25519_KEY_SIZE];
+    std::memcpy(info, HKDF_LABEL, sizeof(HKDF_LABEL));
+    std::memcpy(info + sizeof(HKDF_LABEL), ephemeral.data(), ephemeral.size());
+    std::memcpy(info + sizeof(HKDF_LABEL) + ephemeral.size(), recipient.data(), recipient.size());
+
+    EVP_PKEY_CTX* kdf = ok ? EVP_PKEY_CTX_new_id(EVP_PKEY_HKDF, nullptr) : nullptr;
+    size_t outLen = out.size();
+    ok = kdf && EVP_PKEY_derive_init(kdf) == 1 &&
+         EVP_PKEY_CTX_set_hkdf_md(kdf, EVP_sha256()) == 1 &&
+         EVP_PKEY_CTX_set1_hkdf_key(kdf, shared, static_cast<int>(sharedLen)) == 1 &&
+         EVP_PKEY_CTX_add1_hkdf_info(kdf, info, static_cast<int>(sizeof(info))) == 1 &&
+         EVP_PKEY_derive(kdf, out.data(), &outLen) == 1;
+    EVP_PKEY_CTX_free(kdf);
+    OPENSSL_cleanse(shared, sizeof(shared));
+    return ok;
+}
+
+static bool rawPublicKey(EVP_PKEY* pkey, RawKey& out) {
+    size_t len = out.size();
+    return EVP_PKEY_get_raw_public_key(pkey, out.data(), &len) == 1 && len == out.size();
+}
+
+void CryptoHandler::generateHybridKeyPair(std::vector<unsigned char>& rawPubKey, SecureString& privKeyPem) {
+    EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_X25519, nullptr);
+    EVP_PKEY* pkey = nullptr;
+    bool ok = ctx && EVP_PKEY_keygen_init(ctx) == 1 && EVP_PKEY_keygen(ctx, &pkey) == 1;
+    EVP_PKEY_CTX_free(ctx);
+    if (!ok) return;
+
+    RawKey raw;
+    if (rawPublicKey(pkey, raw)) rawPubKey.assign(raw.begin(), raw.end());
+    BIO* bio = BIO_new(BIO_s_secmem());
+    PEM_write_bio_PrivateKey(bio, pkey, nullptr, nullptr, 0, nullptr, nullptr);
+    char* data = nullptr;
+    long len = BIO_get_mem_data(bio, &data);
+    if (data && len > 0) privKeyPem.assign(data, static_cast<size_t>(len));
+    BIO_free_all(bio);
+    EVP_PKEY_free(pkey);
+}
+
+size_t CryptoHandler::hybridEncrypt(ByteSpan plainText, ByteSpan rawPubKey, MutableByteSpan cipherText) {
+    const size_t needed = plainText.size() + HYBRID_OVERHEAD;
+    if (rawPubKey.size() != X25519_KEY_SIZE) return 0;
+    if (cipherText.size() < needed) return needed;
+
+    RawKey recipient;
+    std::memcpy(recipient.data(), rawPubKey.data(), recipient.size());
+    EVP_PKEY* peer = EVP_PKEY_new_raw_public_key(EVP_PKEY_X25519, nullptr, recipient.data(), recipient.size());
+    EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_X25519, nullptr);
+    EVP_PKEY* ephemeral = nullptr;
+    bool ok = peer && ctx && EVP_PKEY_keygen_init(ctx) == 1 && EVP_PKEY_keygen(ctx, &ephemeral) == 1;
+    EVP_PKEY_CTX_free(ctx);
+
+    RawKey ephemeralPub;
+    MessageKey key;
+    ok = ok && rawPublicKey(ephemeral, ephemeralPub) &&
+         deriveMessageKey(ephemeral, peer, ephemeralPub, recipient, key);
+    EVP_PKEY_free(ephemeral);
+    EVP_PKEY_free(peer);
+    if (!ok) return 0;
+
+    unsigned char* out = u8(cipherText);
+    std::memcpy(out, ephemeralPub.data(), ephemeralPub.size());
+    unsigned char* sealed = out + X25519_KEY_SIZE;
+    AeadStream aead(key.data());
+    ok = aead.seal(key.data() + AeadStream::KEY_SIZE, nullptr, 0, u8(plainText), plainText.size(),
+                   sealed, sealed + plainText.size());
+    OPENSSL_cleanse(key.data(), key.size());
+    return ok ? needed : 0;
+}
+
+size_t CryptoHandler::hybridDecrypt(ByteSpan cipherText, std::string_view privKeyPem, MutableByteSpan plainText) {
+    if (cipherText.size() < HYBRID_OVERHEAD) return 0;
+    const size_t size = cipherText.size() - HYBRID_OVERHEAD;
+    if (plainText.size() < size) return size;
+    KeyCache::KeyPtr own = KeyCache::instance().privateKey(privKeyPem);
+    if (!own || EVP_PKEY_get_id(own.get()) != EVP_PKEY_X25519) return 0;
+
+    RawKey ephemeralPub, recipient;
+    std::memcpy(ephemeralPub.data(), cipherText.data(), ephemeralPub.size());
+    EVP_PKEY* peer = EVP_PKEY_new_raw_public_key(EVP_PKEY_X25519, nullptr, ephemeralPub.data(), ephemeralPub.size());
+    MessageKey key;
+    bool ok = peer && rawPublicKey(own.get(), recipient) &&
+              deriveMessageKey(own.get(), peer, ephemeralPub, recipient, key);
+    EVP_PKEY_free(peer);
+    if (!ok) return 0;
+
+    const unsigned char* sealed = u8(cipherText) + X25519_KEY_SIZE;
+    AeadStream aead(key.data());
+    ok = aead.open(key.data() + AeadStream::KEY_SIZE, nullptr, 0, sealed, size, u8(plainText), sealed + size);
+    OPENSSL_cleanse(key.data(), key.size());
+    if (!ok) {
+        if (size > 0) OPENSSL_cleanse(plainText.data(), size);
+        return 0;
+    }
+    // 0 already means failure, so an empty payload cannot be told apart; callers send non-empty ones
+    return size;
+}
+
+std::vector<unsigned char> CryptoHandler::hybridEncrypt(const std::string& plainText,
+                                                        const std::vector<unsigned char>& rawPubKey) {
+    std::vector<unsigned char> encrypted(plainText.size() + HYBRID_OVERHEAD);
+    if (hybridEncrypt(asBytes(plainText), asBytes(rawPubKey), asWritableBytes(encrypted)) != encrypted.size())
+        return {};
+    return encrypted;
+}
+
+std::string CryptoHandler::hybridDecrypt(const std::vector<unsigned char>& cipherText, std::string_view privKeyPem) {
+    if (cipherText.size() <= HYBRID_OVERHEAD) return "DECRYPTION_FAILED";
+    std::string plain(cipherText.size() - HYBRID_OVERHEAD, '\0');
+    MutableByteSpan out(reinterpret_cast<std::byte*>(plain.data()), plain.size());
+    if (hybridDecrypt(asBytes(cipherText), privKeyPem, out) != plain.size()) return "DECRYPTION_FAILED";
+    return plain;
+}
@@ -0,0 +1,112 @@
+#include "KeyCache.h"
+#include <openssl/bio.h>
+#include <openssl/pem.h>
+#include <cstring>
+
+KeyCache::KeyCache(size_t capacity) {
+    m_public.capacity = capacity ? capacity : 1;
+    m_private.capacity = PRIVATE_CAPACITY;
+}
+
+KeyCache& KeyCache::instance() {
+    static KeyCache cache;
+    return cache;
+}
+
+size_t KeyCache::DigestHash::operator()(const Digest& d) const {
+    size_t h;
+    std::memcpy(&h, d.data(), sizeof(h));   // already uniformly distributed
+    return h;
+}
+
+KeyCache::KeyPtr KeyCache::publicKey(std::string_view pem) {
+    return lookup(pem, false);
+}
+
+KeyCache::KeyPtr KeyCache::privateKey(std::string_view pem) {
+    return lookup(pem, true);
+}
+
+KeyCache::KeyPtr KeyCache::lookup(std::string_view pem, bool isPrivate) {
+    // The kind is hashed in too: the same text must not come back as the other kind of key
+    Digest digest;
+    const unsigned char kind = isPrivate ? 1 : 0;
+    EVP_MD_CTX* md = EVP_MD_CTX_new();
+    bool hashed = md && EVP_DigestInit_ex(md, EVP_sha256(), nullptr) == 1 &&
+                  EVP_DigestUpdate(md, &kind, 1) == 1 &&
+                  EVP_DigestUpdate(md, pem.data(), pem.size()) == 1 &&
+                  EVP_DigestFinal_ex(md, digest.data(), nullptr) == 1;
+    EVP_MD_CTX_free(md);
+    if (!hashed) return nullptr;
+
+    Pool& pool = isPrivate ? m_private : m_public;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = pool.index.find(digest);
+        if (it != pool.index.end()) {
+            ++m_stats.hits;
+            pool.lru.splice(pool.lru.begin(), pool.lru, it->second);
+            return it->second->key;
+        }
+        ++m_stats.misses;
+    }
+
+    // Parse without holding the lock; PEM decoding is the slow part we are caching
+    BIO* bio = BIO_new_mem_buf(pem.data(), static_cast<int>(pem.size()));
+    EVP_PKEY* raw = isPrivate ? PEM_read_bio_PrivateKey(bio, nullptr, nullptr, nullptr)
+                              : PEM_read_bio_PUBKEY(bio, nullptr, nullptr, nullptr);
+    BIO_free(bio);
+    if (!raw) return nullptr;
+    KeyPtr key(raw, EVP_PKEY_free);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = pool.index.find(digest);
+    if (it != pool.index.end())
+        return it->second->key;     // another thread parsed it meanwhile
+    pool.lru.push_front(Entry{ digest, key });
+    pool.index.emplace(digest, pool.lru.begin());
+    evictLocked(pool);
+    return key;
+}
+
+void KeyCache::evictLocked(Pool& pool) {
+    while (pool.lru.size() > pool.capacity) {
+        pool.index.erase(pool.lru.back().digest);
+        pool.lru.pop_back();
+        ++m_stats.evictions;
+    }
+}
+
+void KeyCache::setCapacity(size_t capacity) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_public.capacity = capacity ? capacity : 1;
+    evictLocked(m_public);
+}
+
+KeyCache::Stats KeyCache::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Stats s = m_stats;
+    s.size = m_public.lru.size();
+    s.capacity = m_public.capacity;
+    s.privateSize = m_private.lru.size();
+    return s;
+}
+
+void KeyCache::resetStats() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats = Stats();
+}
+
+void KeyCache::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_public.index.clear();
+    m_public.lru.clear();
+    m_private.index.clear();
+    m_private.lru.clear();
+}
+
+void KeyCache::clearPrivateKeys() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_private.index.clear();
+    m_private.lru.clear();
+}
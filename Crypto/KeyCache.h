@@ -0,0 +1,74 @@
+#ifndef KEY_CACHE_H
+#define KEY_CACHE_H
+
+#include <openssl/evp.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+// Size-bounded LRU of parsed keys, keyed by SHA-256 of the PEM text, shared by the RSA, ECDSA
+// and hybrid-encryption paths. Keys are handed out ref-counted, so one evicted while in use
+// stays valid for whoever holds it. Thread-safe.
+// Private keys live in the general OpenSSL heap once parsed, so they get their own pool of
+// PRIVATE_CAPACITY entries (a device holds one or two) that clearPrivateKeys() drops.
+class KeyCache {
+public:
+    using KeyPtr = std::shared_ptr<EVP_PKEY>;
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        size_t size = 0;
+        size_t capacity = 0;
+        size_t privateSize = 0;
+    };
+
+    static constexpr size_t DEFAULT_CAPACITY = 512;
+    static constexpr size_t PRIVATE_CAPACITY = 4;
+
+    explicit KeyCache(size_t capacity = DEFAULT_CAPACITY);
+    static KeyCache& instance();
+
+    // Null when the PEM does not parse
+    KeyPtr publicKey(std::string_view pem);
+    KeyPtr privateKey(std::string_view pem);
+
+    // Public-key pool only; the private pool stays at PRIVATE_CAPACITY
+    void setCapacity(size_t capacity);
+    Stats stats() const;
+    void resetStats();
+    void clear();
+    // Drops the cached private keys; ones still held by callers go when released
+    void clearPrivateKeys();
+
+private:
+    using Digest = std::array<unsigned char, 32>;
+    struct DigestHash {
+        size_t operator()(const Digest& d) const;
+    };
+    struct Entry {
+        Digest digest;
+        KeyPtr key;
+    };
+    struct Pool {
+        std::list<Entry> lru;     // most recently used first
+        std::unordered_map<Digest, std::list<Entry>::iterator, DigestHash> index;
+        size_t capacity;
+    };
+
+    KeyPtr lookup(std::string_view pem, bool isPrivate);
+    void evictLocked(Pool& pool);
+
+    mutable std::mutex m_mutex;
+    Pool m_public;
+    Pool m_private;
+    Stats m_stats;
+};
+
+#endif
@@ -0,0 +1,272 @@
+#include "KeyPairPool.h"
+#include "AeadStream.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__APPLE__)
+#include <pthread.h>
+#elif defined(__linux__)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+// File layout: MAGIC | nonce | sealed(count, {pubLen, pub, privLen, priv}*) | tag.
+// The magic doubles as associated data, so a file from another format version fails to open.
+static constexpr unsigned char MAGIC[] = { 'F', 'P', 'K', 'P', 1 };
+static constexpr uint32_t MAX_STORED = 4096;
+
+// Flushed data and the file's metadata on stable storage, not just in the OS cache
+static bool syncFile(std::FILE* f) {
+    if (std::fflush(f) != 0) return false;
+#if defined(_WIN32)
+    return FlushFileBuffers(reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(f)))) != 0;
+#else
+    return fsync(fileno(f)) == 0;
+#endif
+}
+
+// Makes a rename or removal in the directory holding `path` durable (on Windows the
+// MOVEFILE_WRITE_THROUGH rename already is)
+static bool syncParentDirectory(const std::string& path) {
+#if defined(_WIN32)
+    (void)path;
+    return true;
+#else
+    const size_t slash = path.find_last_of('/');
+    const std::string dir = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    const int fd = open(dir.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    const bool ok = fsync(fd) == 0;
+    close(fd);
+    return ok;
+#endif
+}
+
+// Key generation should only use cycles the UI and audio threads leave over
+static void lowerThreadPriority() {
+#if defined(_WIN32)
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+#elif defined(__APPLE__)
+    pthread_set_qos_class_self_np(QOS_CLASS_BACKGROUND, 0);
+#elif defined(__linux__)
+    // Linux (and Android) apply nice values per thread
+    setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 19);
+#endif
+}
+
+static void putU32(SecureBuffer& out, uint32_t v) {
+    for (int i = 0; i < 4; ++i) out.push_back(static_cast<unsigned char>(v >> (8 * i)));
+}
+
+static bool getU32(const unsigned char*& p, const unsigned char* end, uint32_t& v) {
+    if (end - p < 4) return false;
+    v = uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+    p += 4;
+    return true;
+}
+
+template <typename String>
+static bool getString(const unsigned char*& p, const unsigned char* end, String& s) {
+    uint32_t len = 0;
+    if (!getU32(p, end, len) || static_cast<size_t>(end - p) < len) return false;
+    s.assign(reinterpret_cast<const char*>(p), len);
+    p += len;
+    return true;
+}
+
+KeyPairPool::KeyPairPool(Generator generate, size_t target,
+                         std::string storagePath, const unsigned char* storageKey)
+    : m_generate(generate)
+    , m_path(storageKey ? std::move(storagePath) : std::string())
+    , m_target(target) {
+    if (!m_path.empty()) {
+        m_storageKey.assign(storageKey, storageKey + STORAGE_KEY_SIZE);
+        load();
+    }
+    m_worker = std::thread(&KeyPairPool::run, this);
+}
+
+KeyPairPool::~KeyPairPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    m_worker.join();
+    persist();      // keep whatever was generated since the pool last filled up
+}
+
+KeyPairPool::KeyPair KeyPairPool::take() {
+    KeyPair kp;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_taken;
+        if (!m_pool.empty()) {
+            kp = std::move(m_pool.front());
+            m_pool.pop_front();
+        } else {
+            ++m_misses;
+        }
+    }
+    m_wake.notify_one();
+    if (kp.privateKeyPem.empty()) {
+        m_generate(kp.publicKeyPem, kp.privateKeyPem);
+        return kp;
+    }
+    // A stale file would hand this pair out again after a restart
+    if (!persist() && std::remove(m_path.c_str()) == 0)
+        syncParentDirectory(m_path);
+    return kp;
+}
+
+void KeyPairPool::setTarget(size_t target) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_target = target;
+    }
+    m_wake.notify_one();
+}
+
+KeyPairPool::Stats KeyPairPool::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Stats s;
+    s.depth = m_pool.size();
+    s.target = m_target;
+    s.generated = m_generated;
+    s.taken = m_taken;
+    s.misses = m_misses;
+    if (m_generated > 0 && m_generateSeconds > 0) {
+        s.averageGenerateMs = m_generateSeconds * 1000.0 / double(m_generated);
+        s.refillPerSecond = double(m_generated) / m_generateSeconds;
+    }
+    return s;
+}
+
+void KeyPairPool::run() {
+    lowerThreadPriority();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_wake.wait(lock, [this] { return m_stop || m_pool.size() < m_target; });
+        if (m_stop) return;
+        lock.unlock();
+
+        KeyPair kp;
+        const auto start = std::chrono::steady_clock::now();
+        m_generate(kp.publicKeyPem, kp.privateKeyPem);
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        lock.lock();
+        if (kp.publicKeyPem.empty() || kp.privateKeyPem.empty()) {
+            // Generation failing is not going to fix itself in a tight loop
+            m_wake.wait_for(lock, std::chrono::seconds(1), [this] { return m_stop; });
+            continue;
+        }
+        m_pool.push_back(std::move(kp));
+        ++m_generated;
+        m_generateSeconds += elapsed.count();
+        // Only a take must reach the file at once; a refill is written in one go when done
+        if (m_pool.size() >= m_target) {
+            lock.unlock();
+            persist();
+            lock.lock();
+        }
+    }
+}
+
+bool KeyPairPool::load() {
+    std::FILE* f = std::fopen(m_path.c_str(), "rb");
+    if (!f) return false;
+    std::vector<unsigned char> file;
+    unsigned char chunk[4096];
+    size_t n;
+    while ((n = std::fread(chunk, 1, sizeof(chunk), f)) > 0)
+        file.insert(file.end(), chunk, chunk + n);
+    std::fclose(f);
+
+    const size_t overhead = sizeof(MAGIC) + AeadStream::NONCE_SIZE + AeadStream::TAG_SIZE;
+    if (file.size() < overhead || std::memcmp(file.data(), MAGIC, sizeof(MAGIC)) != 0)
+        return false;
+    const unsigned char* nonce = file.data() + sizeof(MAGIC);
+    const unsigned char* sealed = nonce + AeadStream::NONCE_SIZE;
+    const size_t size = file.size() - overhead;
+    const unsigned char* tag = sealed + size;
+
+    SecureBuffer plain(size);
+    AeadStream aead(m_storageKey.data());
+    bool ok = aead.open(nonce, MAGIC, sizeof(MAGIC), sealed, size, plain.data(), tag);
+    std::deque<KeyPair> loaded;
+    const unsigned char* p = plain.data();
+    const unsigned char* end = p + plain.size();
+    uint32_t count = 0;
+    ok = ok && getU32(p, end, count) && count <= MAX_STORED;
+    for (uint32_t i = 0; ok && i < count; ++i) {
+        KeyPair kp;
+        ok = getString(p, end, kp.publicKeyPem) && getString(p, end, kp.privateKeyPem);
+        if (ok) loaded.push_back(std::move(kp));
+    }
+    if (!ok) return false;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pool = std::move(loaded);
+    return true;
+}
+
+// Writes a sealed snapshot next to the file and renames it over, so a crash leaves either
+// the old or the new pool on disk. Both the file and the rename are synced before returning:
+// after take() a power loss must not bring back a file holding the pair just handed out.
+bool KeyPairPool::persist() {
+    if (m_path.empty()) return true;
+    std::lock_guard<std::mutex> fileLock(m_fileMutex);
+
+    SecureBuffer plain;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        size_t size = 4;
+        for (const KeyPair& kp : m_pool) size += 8 + kp.publicKeyPem.size() + kp.privateKeyPem.size();
+        plain.reserve(size);
+        putU32(plain, static_cast<uint32_t>(m_pool.size()));
+        for (const KeyPair& kp : m_pool) {
+            putU32(plain, static_cast<uint32_t>(kp.publicKeyPem.size()));
+            plain.insert(plain.end(), kp.publicKeyPem.begin(), kp.publicKeyPem.end());
+            putU32(plain, static_cast<uint32_t>(kp.privateKeyPem.size()));
+            plain.insert(plain.end(), kp.privateKeyPem.begin(), kp.privateKeyPem.end());
+        }
+    }
+
+    std::vector<unsigned char> file(sizeof(MAGIC) + AeadStream::NONCE_SIZE + plain.size() + AeadStream::TAG_SIZE);
+    std::memcpy(file.data(), MAGIC, sizeof(MAGIC));
+    unsigned char* nonce = file.data() + sizeof(MAGIC);
+    unsigned char* sealed = nonce + AeadStream::NONCE_SIZE;
+    AeadStream aead(m_storageKey.data());
+    const bool sealedOk = AeadStream::randomNonce(nonce) &&
+        aead.seal(nonce, MAGIC, sizeof(MAGIC), plain.data(), plain.size(), sealed, sealed + plain.size());
+    if (!sealedOk) return false;
+
+    const std::string tmp = m_path + ".tmp";
+    std::FILE* f = std::fopen(tmp.c_str(), "wb");
+    if (!f) return false;
+#if !defined(_WIN32)
+    chmod(tmp.c_str(), S_IRUSR | S_IWUSR);
+#endif
+    const bool written = std::fwrite(file.data(), 1, file.size(), f) == file.size() && syncFile(f);
+    if (std::fclose(f) != 0 || !written) {
+        std::remove(tmp.c_str());
+        return false;
+    }
+#if defined(_WIN32)
+    // rename() does not replace an existing file there
+    return MoveFileExA(tmp.c_str(), m_path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return std::rename(tmp.c_str(), m_path.c_str()) == 0 && syncParentDirectory(m_path);
+#endif
+}
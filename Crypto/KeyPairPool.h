@@ -0,0 +1,75 @@
+#ifndef KEY_PAIR_POOL_H
+#define KEY_PAIR_POOL_H
+
+#include "SecureArena.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Keeps `target` ready-made key pairs so handing one out does not wait for key generation
+// (RSA-2048 takes up to seconds on low-end phones). A low-priority background thread tops
+// the pool up; with a storage path the pool is kept in an AES-256-GCM sealed file, so it
+// survives restarts. A pair that was taken is removed from the file before take() returns
+// and is never handed out twice. Thread-safe.
+class KeyPairPool {
+public:
+    using Generator = void (*)(std::string& pubKeyPem, SecureString& privKeyPem);
+
+    struct KeyPair {
+        std::string publicKeyPem;
+        SecureString privateKeyPem;
+    };
+
+    struct Stats {
+        size_t depth = 0;
+        size_t target = 0;
+        uint64_t generated = 0;         // by the background thread
+        uint64_t taken = 0;
+        uint64_t misses = 0;            // takes that found the pool empty and generated inline
+        double averageGenerateMs = 0;
+        double refillPerSecond = 0;     // sustained background rate, from generation time
+    };
+
+    static constexpr size_t STORAGE_KEY_SIZE = 32;
+
+    // e.g. KeyPairPool(&CryptoHandler::generateKeyPair, 8, path, key). An empty storagePath
+    // keeps the pool in memory only; otherwise storageKey holds STORAGE_KEY_SIZE bytes.
+    KeyPairPool(Generator generate, size_t target,
+                std::string storagePath = {}, const unsigned char* storageKey = nullptr);
+    ~KeyPairPool();
+    KeyPairPool(const KeyPairPool&) = delete;
+    KeyPairPool& operator=(const KeyPairPool&) = delete;
+
+    // A pooled pair, or a freshly generated one when the pool has run dry (empty on failure)
+    KeyPair take();
+
+    void setTarget(size_t target);
+    Stats stats() const;
+
+private:
+    void run();
+    bool load();
+    bool persist();
+
+    Generator m_generate;
+    std::string m_path;
+    SecureBuffer m_storageKey;
+
+    mutable std::mutex m_mutex;
+    std::mutex m_fileMutex;     // keeps snapshots reaching the file in the order they were taken
+    std::condition_variable m_wake;
+    std::deque<KeyPair> m_pool;
+    size_t m_target;
+    bool m_stop = false;
+    uint64_t m_generated = 0;
+    uint64_t m_taken = 0;
+    uint64_t m_misses = 0;
+    double m_generateSeconds = 0;
+    std::thread m_worker;
+};
+
+#endif
@@ -0,0 +1,121 @@
+#include "PhoneHash.h"
+#include <openssl/evp.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <thread>
+
+namespace PhoneHash {
+
+// Branch-free compaction: every character is stored, the cursor only advances past digits.
+// Phone numbers are ~15 characters, too short for a vector loop to pay for its setup.
+template <typename Char>
+static size_t normalizeDigits(std::basic_string_view<Char> phone, char* out) {
+    size_t n = 0;
+    for (Char c : phone) {
+        const auto d = static_cast<uint32_t>(c) - uint32_t('0');
+        out[n] = static_cast<char>(c);
+        n += d < 10;
+    }
+    return n;
+}
+
+size_t normalize(std::string_view phone, char* out) {
+    return normalizeDigits(phone, out);
+}
+
+size_t normalize(std::u16string_view phone, char* out) {
+    return normalizeDigits(phone, out);
+}
+
+// OpenSSL 3's one-shot SHA256() fetches the digest and allocates a context on every call
+// (3 allocations per number). Here SHA-256 is fetched once, and each thread (batch workers
+// included) keeps one EVP_MD_CTX re-initialised with EVP_DigestInit_ex2. OpenSSL 3.0 still
+// replaces the provider's small digest state on each init, so one allocation per number remains.
+static const EVP_MD* sha256() {
+    static EVP_MD* md = EVP_MD_fetch(nullptr, "SHA256", nullptr);
+    return md;
+}
+
+static EVP_MD_CTX* scratchContext() {
+    struct Holder {
+        EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+        ~Holder() { EVP_MD_CTX_free(ctx); }
+    };
+    thread_local Holder holder;
+    return holder.ctx;
+}
+
+template <typename Char>
+static bool hashDigits(std::basic_string_view<Char> phone, unsigned char* key) {
+    char local[128];
+    std::string spill;
+    char* digits = local;
+    if (phone.size() > sizeof(local)) {
+        spill.resize(phone.size());
+        digits = spill.data();
+    }
+    const size_t n = normalizeDigits(phone, digits);
+    if (n == 0) return false;
+    EVP_MD_CTX* ctx = scratchContext();
+    return ctx && sha256() &&
+           EVP_DigestInit_ex2(ctx, sha256(), nullptr) == 1 &&
+           EVP_DigestUpdate(ctx, digits, n) == 1 &&
+           EVP_DigestFinal_ex(ctx, key, nullptr) == 1;
+}
+
+bool hash(std::string_view phone, unsigned char* key) {
+    return hashDigits(phone, key);
+}
+
+bool hash(std::u16string_view phone, unsigned char* key) {
+    return hashDigits(phone, key);
+}
+
+// Same fan-out as DigitalSignature::verifyBatch: 64-number blocks, one bitmap word each
+template <typename Char>
+static std::vector<uint64_t> hashAll(const std::basic_string_view<Char>* phones, size_t count,
+                                     unsigned char* keys, unsigned threads) {
+    const size_t words = (count + 63) / 64;
+    std::vector<uint64_t> bitmap(words, 0);
+    if (count == 0) return bitmap;
+
+    std::atomic<size_t> nextWord{0};
+    auto worker = [&]() {
+        for (size_t w = nextWord++; w < words; w = nextWord++) {
+            uint64_t bits = 0;
+            const size_t end = std::min(count, (w + 1) * 64);
+            for (size_t i = w * 64; i < end; ++i) {
+                unsigned char* key = keys + i * KEY_SIZE;
+                if (hashDigits(phones[i], key))
+                    bits |= uint64_t(1) << (i % 64);
+                else
+                    std::memset(key, 0, KEY_SIZE);
+            }
+            bitmap[w] = bits;
+        }
+    };
+
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::min<size_t>(threads, words));
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t)
+        pool.emplace_back(worker);
+    worker();
+    for (std::thread& t : pool)
+        t.join();
+    return bitmap;
+}
+
+std::vector<uint64_t> hashBatch(const std::string_view* phones, size_t count,
+                                unsigned char* keys, unsigned threads) {
+    return hashAll(phones, count, keys, threads);
+}
+
+std::vector<uint64_t> hashBatch(const std::u16string_view* phones, size_t count,
+                                unsigned char* keys, unsigned threads) {
+    return hashAll(phones, count, keys, threads);
+}
+
+} // namespace PhoneHash
@@ -0,0 +1,37 @@
+#ifndef PHONE_HASH_H
+#define PHONE_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Phone number -> 32-byte directory key: SHA-256 over the number's ASCII digits, everything
+// else ("+", spaces, dashes, other scripts' digits) dropped.
+namespace PhoneHash {
+
+inline constexpr size_t KEY_SIZE = 32;
+
+// Writes the ASCII digits of `phone` to out (room for phone.size() chars); returns how many
+size_t normalize(std::string_view phone, char* out);
+size_t normalize(std::u16string_view phone, char* out);
+
+// False (key untouched) when the number has no digits
+bool hash(std::string_view phone, unsigned char* key);
+bool hash(std::u16string_view phone, unsigned char* key);
+
+// Keys for phones[0..count) into keys[i * KEY_SIZE], on up to `threads` threads (0 = one per
+// core). Numbers without digits get an all-zero key. Returns a bitmap: bit (i % 64) of word
+// (i / 64) is set when number i produced a key.
+std::vector<uint64_t> hashBatch(const std::string_view* phones, size_t count,
+                                unsigned char* keys, unsigned threads = 0);
+std::vector<uint64_t> hashBatch(const std::u16string_view* phones, size_t count,
+                                unsigned char* keys, unsigned threads = 0);
+
+inline bool hasKey(const std::vector<uint64_t>& bitmap, size_t i) {
+    return (bitmap[i / 64] >> (i % 64)) & 1u;
+}
+
+} // namespace PhoneHash
+
+#endif
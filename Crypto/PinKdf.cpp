@@ -0,0 +1,47 @@
+#include "PinKdf.h"
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <algorithm>
+#include <chrono>
+
+namespace PinKdf {
+
+bool randomSalt(unsigned char* salt, size_t size) {
+    return RAND_bytes(salt, static_cast<int>(size)) == 1;
+}
+
+bool derive(const char* pin, size_t pinLen,
+            const unsigned char* salt, size_t saltLen,
+            uint32_t iterations, unsigned char* out, size_t outLen) {
+    return PKCS5_PBKDF2_HMAC(pin, static_cast<int>(pinLen), salt, static_cast<int>(saltLen),
+                             static_cast<int>(iterations), EVP_sha256(),
+                             static_cast<int>(outLen), out) == 1;
+}
+
+double measure(uint32_t iterations) {
+    const char pin[] = "000000";
+    unsigned char salt[SALT_SIZE] = {};
+    unsigned char out[HASH_SIZE];
+    auto start = std::chrono::steady_clock::now();
+    derive(pin, sizeof(pin) - 1, salt, sizeof(salt), iterations, out, sizeof(out));
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+uint32_t calibrate(double targetMs) {
+    // A short probe is enough: PBKDF2 cost is linear in the iteration count
+    const uint32_t probe = 20000;
+    double ms = measure(probe);
+    for (int i = 0; i < 2; ++i)
+        ms = std::min(ms, measure(probe));
+    if (ms <= 0.0) return MAX_ITERATIONS;
+    double scaled = probe * (targetMs / ms);
+    if (scaled >= MAX_ITERATIONS) return MAX_ITERATIONS;
+    return std::max(MIN_ITERATIONS, static_cast<uint32_t>(scaled));
+}
+
+bool equals(const unsigned char* a, const unsigned char* b, size_t size) {
+    return CRYPTO_memcmp(a, b, size) == 0;
+}
+
+} // namespace PinKdf
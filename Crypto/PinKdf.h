@@ -0,0 +1,44 @@
+#ifndef PIN_KDF_H
+#define PIN_KDF_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Salted, tunable-cost PIN hashing (PBKDF2-HMAC-SHA256). The iteration count is stored with
+// the hash, so verification always costs exactly what was chosen when the PIN was set.
+namespace PinKdf {
+
+inline constexpr size_t SALT_SIZE = 16;
+inline constexpr size_t HASH_SIZE = 32;
+inline constexpr uint32_t MIN_ITERATIONS = 50000;
+inline constexpr uint32_t MAX_ITERATIONS = 5000000;
+
+// Starting costs aimed at ~250 ms per verification on each class of phone (calibrate() measures)
+struct DevicePreset {
+    const char* name;
+    uint32_t iterations;
+};
+inline constexpr DevicePreset DEVICE_PRESETS[] = {
+    { "low-end", 120000 },
+    { "mid-range", 300000 },
+    { "flagship", 600000 },
+};
+
+bool randomSalt(unsigned char* salt, size_t size);
+
+bool derive(const char* pin, size_t pinLen,
+            const unsigned char* salt, size_t saltLen,
+            uint32_t iterations, unsigned char* out, size_t outLen);
+
+// Iteration count that takes about targetMs on this device, clamped to [MIN, MAX]_ITERATIONS
+uint32_t calibrate(double targetMs);
+
+// Milliseconds one derive() takes here at the given cost
+double measure(uint32_t iterations);
+
+// Constant-time comparison
+bool equals(const unsigned char* a, const unsigned char* b, size_t size);
+
+} // namespace PinKdf
+
+#endif
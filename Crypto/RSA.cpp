@@ -1,10 +1,12 @@
 #include "CryptoHandler.h"
+#include "KeyCache.h"
+#include <openssl/evp.h>
 #include <openssl/rsa.h>
 #include <openssl/pem.h>
 #include <openssl/bio.h>
 #include <cstdlib>
 
-void CryptoHandler::generateKeyPair(std::string& pubKey, std::string& privKey) {
+void CryptoHandler::generateKeyPair(std::string& pubKey, SecureString& privKey) {
     const int bits = 2048;
         BIGNUM* bn = BN_new();
     BN_set_word(bn, RSA_F4);
@@ -21,7 +23,7 @@ void CryptoHandler::generateKeyPair(std::string& pubKey, std::string& privKey) {
     if (pub_data && pub_len > 0) pubKey.assign(pub_data, static_cast<size_t>(pub_len));
     BIO_free_all(pub);
 
-    BIO* priv = BIO_new(BIO_s_mem());
+    BIO* priv = BIO_new(BIO_s_secmem());     // buffer is cleansed when freed
     PEM_write_bio_RSAPrivateKey(priv, rsa, nullptr, nullptr, 0, nullptr, nullptr);
     char* priv_data = nullptr;
     long priv_len = BIO_get_mem_data(priv, &priv_data);
@@ -32,32 +34,58 @@ void CryptoHandler::generateKeyPair(std::string& pubKey, std::string& privKey) {
     BN_free(bn);
 }
 
+// RSA-OAEP through EVP on keys from the shared KeyCache (same padding as RSA_PKCS1_OAEP_PADDING)
+size_t CryptoHandler::encrypt(ByteSpan plainText, std::string_view pubKey, MutableByteSpan cipherText) {
+    KeyCache::KeyPtr key = KeyCache::instance().publicKey(pubKey);
+    if (!key) return 0;
+    EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new(key.get(), nullptr);
+    if (!ctx) return 0;
+
+    size_t len = 0;
+    if (EVP_PKEY_encrypt_init(ctx) != 1 ||
+        EVP_PKEY_CTX_set_rsa_padding(ctx, RSA_PKCS1_OAEP_PADDING) != 1 ||
+        EVP_PKEY_encrypt(ctx, nullptr, &len, u8(plainText), plainText.size()) != 1) {
+        len = 0;
+    } else if (cipherText.size() >= len) {
+        len = cipherText.size();
+        if (EVP_PKEY_encrypt(ctx, u8(cipherText), &len, u8(plainText), plainText.size()) != 1)
+            len = 0;
+    }
+    EVP_PKEY_CTX_free(ctx);
+    return len;
+}
+
+size_t CryptoHandler::decrypt(ByteSpan cipherText, std::string_view privKey, MutableByteSpan plainText) {
+    KeyCache::KeyPtr key = KeyCache::instance().privateKey(privKey);
+    if (!key) return 0;
+    EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new(key.get(), nullptr);
+    if (!ctx) return 0;
+
+    // The size query gives the upper bound (modulus size); the actual plaintext is shorter
+    size_t len = 0;
+    if (EVP_PKEY_decrypt_init(ctx) != 1 ||
+        EVP_PKEY_CTX_set_rsa_padding(ctx, RSA_PKCS1_OAEP_PADDING) != 1 ||
+        EVP_PKEY_decrypt(ctx, nullptr, &len, u8(cipherText), cipherText.size()) != 1) {
+        len = 0;
+    } else if (plainText.size() >= len) {
+        len = plainText.size();
+        if (EVP_PKEY_decrypt(ctx, u8(plainText), &len, u8(cipherText), cipherText.size()) != 1)
+            len = 0;
+    }
+    EVP_PKEY_CTX_free(ctx);
+    return len;
+}
+
 std::vector<unsigned char> CryptoHandler::encrypt(const std::string& plainText, const std::string& pubKey) {
-    BIO* bio = BIO_new_mem_buf(pubKey.data(), static_cast<int>(pubKey.size()));
-    RSA* rsa = PEM_read_bio_RSA_PUBKEY(bio, nullptr, nullptr, nullptr);
-    BIO_free(bio);
-    if (!rsa) return {};
-
-    std::vector<unsigned char> encrypted(static_cast<size_t>(RSA_size(rsa)));
-    int result = RSA_public_encrypt(static_cast<int>(plainText.size()),
-                                    reinterpret_cast<const unsigned char*>(plainText.c_str()),
-                                    encrypted.data(), rsa, RSA_PKCS1_OAEP_PADDING);
-    RSA_free(rsa);
-    if (result <= 0) return {};
-    encrypted.resize(static_cast<size_t>(result));
+    std::vector<unsigned char> encrypted(encrypt(asBytes(plainText), pubKey, MutableByteSpan()));
+    if (encrypted.empty()) return {};
+    encrypted.resize(encrypt(asBytes(plainText), pubKey, asWritableBytes(encrypted)));
     return encrypted;
 }
 
-std::string CryptoHandler::decrypt(const std::vector<unsigned char>& cipherText, const std::string& privKey) {
-    BIO* bio = BIO_new_mem_buf(privKey.data(), static_cast<int>(privKey.size()));
-    RSA* rsa = PEM_read_bio_RSAPrivateKey(bio, nullptr, nullptr, nullptr);
-    BIO_free(bio);
-    if (!rsa) return "DECRYPTION_FAILED";
-
-    std::vector<unsigned char> decrypted(static_cast<size_t>(RSA_size(rsa)));
-    int result = RSA_private_decrypt(static_cast<int>(cipherText.size()), cipherText.data(),
-                                     decrypted.data(), rsa, RSA_PKCS1_OAEP_PADDING);
-    RSA_free(rsa);
-    if (result <= 0) return "DECRYPTION_FAILED";
-    return std::string(reinterpret_cast<char*>(decrypted.data()), static_cast<size_t>(result));
-}
\ No newline at end of file
+std::string CryptoHandler::decrypt(const std::vector<unsigned char>& cipherText, std::string_view privKey) {
+    std::vector<unsigned char> buffer(decrypt(asBytes(cipherText), privKey, MutableByteSpan()));
+    size_t len = buffer.empty() ? 0 : decrypt(asBytes(cipherText), privKey, asWritableBytes(buffer));
+    if (len == 0) return "DECRYPTION_FAILED";
+    return std::string(reinterpret_cast<const char*>(buffer.data()), len);
+}
@@ -0,0 +1,127 @@
+#include "SecureArena.h"
+#include <openssl/crypto.h>
+#include <cstdlib>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+static_assert(SecureArena::MAX_BLOCK == SecureArena::MIN_BLOCK << 9, "CLASS_COUNT out of step");
+
+static unsigned char* reserveRegion(size_t size, bool& locked) {
+#if defined(_WIN32)
+    void* p = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (!p) return nullptr;
+    locked = VirtualLock(p, size) != 0;
+#else
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return nullptr;
+    // May fail under a low RLIMIT_MEMLOCK; the region is still wiped, just swappable
+    locked = mlock(p, size) == 0;
+#if defined(MADV_DONTDUMP)
+    madvise(p, size, MADV_DONTDUMP);
+#endif
+#endif
+    return static_cast<unsigned char*>(p);
+}
+
+static void releaseRegion(unsigned char* p, size_t size, bool locked) {
+#if defined(_WIN32)
+    if (locked) VirtualUnlock(p, size);
+    VirtualFree(p, 0, MEM_RELEASE);
+#else
+    if (locked) munlock(p, size);
+    munmap(p, size);
+#endif
+}
+
+SecureArena::SecureArena(size_t size) {
+    m_base = reserveRegion(size, m_stats.locked);
+    m_size = m_base ? size : 0;
+    m_stats.capacity = m_size;
+}
+
+SecureArena::~SecureArena() {
+    if (!m_base) return;
+    OPENSSL_cleanse(m_base, m_size);
+    releaseRegion(m_base, m_size, m_stats.locked);
+}
+
+// Never destroyed: secrets freed during static destruction still need somewhere to go
+SecureArena& SecureArena::instance() {
+    static SecureArena* arena = new SecureArena;
+    return *arena;
+}
+
+size_t SecureArena::classOf(size_t size) {
+    size_t c = 0;
+    while ((MIN_BLOCK << c) < size) ++c;
+    return c;
+}
+
+bool SecureArena::owns(const void* p) const {
+    const auto* b = static_cast<const unsigned char*>(p);
+    return m_base && b >= m_base && b < m_base + m_size;
+}
+
+void* SecureArena::allocate(size_t size) {
+    if (size == 0) size = 1;
+    if (size <= MAX_BLOCK) {
+        const size_t c = classOf(size);
+        const size_t block = MIN_BLOCK << c;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        void* p = nullptr;
+        if (FreeBlock* f = m_free[c]) {
+            m_free[c] = f->next;
+            f->next = nullptr;      // blocks are handed out zeroed
+            p = f;
+        } else if (m_size - m_bump >= block) {
+            p = m_base + m_bump;
+            m_bump += block;
+            m_stats.reserved = m_bump;
+        }
+        if (p) {
+            ++m_stats.allocations;
+            m_stats.inUse += block;
+            return p;
+        }
+    }
+    void* p = std::malloc(size);
+    if (!p) throw std::bad_alloc();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_stats.allocations;
+    ++m_stats.fallbacks;
+    return p;
+}
+
+void SecureArena::deallocate(void* p, size_t size) {
+    if (!p) return;
+    if (size == 0) size = 1;
+    if (!owns(p)) {
+        OPENSSL_cleanse(p, size);
+        std::free(p);
+        return;
+    }
+    const size_t c = classOf(size);
+    OPENSSL_cleanse(p, MIN_BLOCK << c);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto* f = static_cast<FreeBlock*>(p);
+    f->next = m_free[c];
+    m_free[c] = f;
+    m_stats.inUse -= MIN_BLOCK << c;
+}
+
+SecureArena::Stats SecureArena::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void SecureString::wipe() noexcept {
+    const size_t cap = capacity();
+    resize(cap);        // within capacity, so no reallocation; exposes every byte of the buffer
+    OPENSSL_cleanse(data(), cap);
+    clear();
+}
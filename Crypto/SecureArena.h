@@ -0,0 +1,105 @@
+#ifndef SECURE_ARENA_H
+#define SECURE_ARENA_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Memory for secrets (private key PEMs, PIN verifiers, session keys): one region reserved up
+// front, locked against swapping and excluded from core dumps where the OS allows, carved
+// into power-of-two blocks that are recycled through per-size free lists. Every block is
+// wiped when released. Requests larger than MAX_BLOCK, or made once the region is used up,
+// fall back to the ordinary heap but are still wiped. Thread-safe.
+class SecureArena {
+public:
+    static constexpr size_t DEFAULT_SIZE = 256 * 1024;
+    static constexpr size_t MIN_BLOCK = 32;
+    static constexpr size_t MAX_BLOCK = 16 * 1024;
+
+    struct Stats {
+        size_t capacity = 0;
+        size_t reserved = 0;        // carved into blocks so far (high-water mark)
+        size_t inUse = 0;
+        uint64_t allocations = 0;
+        uint64_t fallbacks = 0;     // served from the general heap
+        bool locked = false;        // region is pinned in RAM
+    };
+
+    explicit SecureArena(size_t size = DEFAULT_SIZE);
+    ~SecureArena();
+    SecureArena(const SecureArena&) = delete;
+    SecureArena& operator=(const SecureArena&) = delete;
+
+    static SecureArena& instance();
+
+    void* allocate(size_t size);
+    // size must be the one passed to allocate()
+    void deallocate(void* p, size_t size);
+    bool owns(const void* p) const;
+    Stats stats() const;
+
+private:
+    static constexpr size_t CLASS_COUNT = 10;     // MIN_BLOCK << 0 .. MAX_BLOCK
+    static size_t classOf(size_t size);
+
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    unsigned char* m_base = nullptr;
+    size_t m_size = 0;
+    size_t m_bump = 0;
+    std::array<FreeBlock*, CLASS_COUNT> m_free{};
+    mutable std::mutex m_mutex;
+    Stats m_stats;
+};
+
+template <typename T>
+struct SecureAllocator {
+    using value_type = T;
+
+    SecureAllocator() noexcept = default;
+    template <typename U>
+    SecureAllocator(const SecureAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        if (n > size_t(-1) / sizeof(T)) throw std::bad_array_new_length();
+        return static_cast<T*>(SecureArena::instance().allocate(n * sizeof(T)));
+    }
+    void deallocate(T* p, size_t n) noexcept { SecureArena::instance().deallocate(p, n * sizeof(T)); }
+
+    template <typename U>
+    bool operator==(const SecureAllocator<U>&) const noexcept { return true; }
+};
+
+using SecureBuffer = std::vector<unsigned char, SecureAllocator<unsigned char>>;
+
+// Short strings live inside the object itself (SSO), which the allocator never sees, so the
+// destructor wipes the whole capacity as well
+class SecureString : public std::basic_string<char, std::char_traits<char>, SecureAllocator<char>> {
+public:
+    using Base = std::basic_string<char, std::char_traits<char>, SecureAllocator<char>>;
+    using Base::Base;
+    SecureString() = default;
+    SecureString(std::string_view s) : Base(s.data(), s.size()) {}
+    SecureString(const SecureString&) = default;
+    SecureString(SecureString&& other) noexcept : Base(std::move(other)) { other.wipe(); }
+    SecureString& operator=(const SecureString&) = default;
+    SecureString& operator=(SecureString&& other) noexcept {
+        wipe();
+        Base::operator=(std::move(other));
+        other.wipe();
+        return *this;
+    }
+    ~SecureString() { wipe(); }
+
+    // Zeroes the contents, including bytes beyond size(), and empties the string
+    void wipe() noexcept;
+};
+
+#endif
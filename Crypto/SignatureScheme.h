@@ -0,0 +1,109 @@
+#ifndef SIGNATURE_SCHEME_H
+#define SIGNATURE_SCHEME_H
+
+#include "DigitalSignature.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace DigitalSignature {
+
+// Identifies the algorithm in stored and transmitted transactions
+enum class SchemeId : uint8_t {
+    P256 = 1,
+    Ed25519 = 2,
+};
+
+const char* schemeName(SchemeId id);
+// Which scheme a private key PEM belongs to; false when it doesn't parse or fits neither
+bool schemeOfPrivateKey(std::string_view privKeyPem, SchemeId& id);
+
+// Ed25519 keys with the same interface as SigningKey / VerifyingKey
+class Ed25519SigningKey {
+public:
+    explicit Ed25519SigningKey(std::string_view privKeyPem);
+    Ed25519SigningKey(const Ed25519SigningKey&) = delete;
+    Ed25519SigningKey& operator=(const Ed25519SigningKey&) = delete;
+
+    bool isValid() const { return m_pkey != nullptr; }
+    size_t sign(ByteSpan message, MutableByteSpan signature) const;
+    std::vector<unsigned char> sign(const void* message, size_t size) const;
+    std::vector<unsigned char> sign(const std::string& message) const { return sign(message.data(), message.size()); }
+    std::string publicKeyPem() const;
+
+private:
+    KeyCache::KeyPtr m_pkey;
+};
+
+class Ed25519VerifyingKey {
+public:
+    explicit Ed25519VerifyingKey(std::string_view pubKeyPem);
+    Ed25519VerifyingKey(const Ed25519VerifyingKey&) = delete;
+    Ed25519VerifyingKey& operator=(const Ed25519VerifyingKey&) = delete;
+
+    bool isValid() const { return m_pkey != nullptr; }
+    bool verify(ByteSpan message, ByteSpan signature) const;
+    bool verify(const void* message, size_t size, const unsigned char* signature, size_t signatureSize) const {
+        return verify({ static_cast<const std::byte*>(message), size },
+                      { reinterpret_cast<const std::byte*>(signature), signatureSize });
+    }
+    bool verify(const std::string& message, const std::vector<unsigned char>& signature) const {
+        return verify(asBytes(message), asBytes(signature));
+    }
+    // The 32 bytes that actually need to cross the ultrasound link
+    std::vector<unsigned char> rawPublicKey() const;
+
+private:
+    KeyCache::KeyPtr m_pkey;
+};
+
+void generateEd25519KeyPair(std::string& pubKeyPem, SecureString& privKeyPem);
+
+// --- Scheme policies ---
+
+// ECDSA P-256 / SHA-256: DER signatures of 70-72 bytes
+struct P256 {
+    using SigningKey = DigitalSignature::SigningKey;
+    using VerifyingKey = DigitalSignature::VerifyingKey;
+    static constexpr SchemeId id = SchemeId::P256;
+    static constexpr size_t maxSignatureSize = 72;
+    static void generateKeyPair(std::string& pub, SecureString& priv) { DigitalSignature::generateKeyPair(pub, priv); }
+};
+
+// Ed25519: fixed 64-byte signatures, 32-byte public keys
+struct Ed25519 {
+    using SigningKey = Ed25519SigningKey;
+    using VerifyingKey = Ed25519VerifyingKey;
+    static constexpr SchemeId id = SchemeId::Ed25519;
+    static constexpr size_t maxSignatureSize = 64;
+    static void generateKeyPair(std::string& pub, SecureString& priv) { generateEd25519KeyPair(pub, priv); }
+};
+
+// Compile-time choice of signature algorithm: code written against SignatureScheme<S>
+// changes algorithm by changing S, with no runtime dispatch.
+template <typename Policy>
+struct SignatureScheme {
+    using SigningKey = typename Policy::SigningKey;
+    using VerifyingKey = typename Policy::VerifyingKey;
+    static constexpr SchemeId id = Policy::id;
+    static constexpr size_t maxSignatureSize = Policy::maxSignatureSize;
+
+    static const char* name() { return schemeName(id); }
+    static void generateKeyPair(std::string& pubKeyPem, SecureString& privKeyPem) {
+        Policy::generateKeyPair(pubKeyPem, privKeyPem);
+    }
+    static std::vector<unsigned char> sign(const std::string& message, std::string_view privKeyPem) {
+        return SigningKey(privKeyPem).sign(message);
+    }
+    static size_t sign(std::string_view message, std::string_view privKeyPem, MutableByteSpan signature) {
+        return SigningKey(privKeyPem).sign(asBytes(message), signature);
+    }
+    static bool verify(std::string_view message, ByteSpan signature, std::string_view pubKeyPem) {
+        return VerifyingKey(pubKeyPem).verify(asBytes(message), signature);
+    }
+};
+
+} // namespace DigitalSignature
+
+#endif
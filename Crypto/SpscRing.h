@@ -0,0 +1,119 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+// Fixed-size, lock-free ring for exactly one producer thread and one consumer thread, e.g.
+// an audio capture callback feeding a DSP thread. push() never blocks or allocates: what
+// doesn't fit is dropped and counted, so the producer can't be held up by a slow consumer.
+// The two indices live on separate cache lines, and each side keeps a cached copy of the
+// other's index so the shared lines are only touched when the cached view runs out.
+template <typename T>
+class SpscRing {
+    static_assert(std::is_trivially_copyable_v<T>, "SpscRing copies items with memcpy");
+
+public:
+    static constexpr size_t CACHE_LINE = 64;
+
+    // Capacity is rounded up to a power of two
+    explicit SpscRing(size_t capacity) {
+        m_capacity = 1;
+        while (m_capacity < capacity) m_capacity <<= 1;
+        m_mask = m_capacity - 1;
+        m_items = static_cast<T*>(::operator new(m_capacity * sizeof(T), std::align_val_t(CACHE_LINE)));
+    }
+    ~SpscRing() { ::operator delete(m_items, std::align_val_t(CACHE_LINE)); }
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    size_t capacity() const { return m_capacity; }
+
+    // Producer: returns how many items were stored; the rest count as overruns
+    size_t push(const T* items, size_t count) {
+        const size_t write = m_write.load(std::memory_order_relaxed);
+        if (m_capacity - (write - m_readCache) < count)
+            m_readCache = m_read.load(std::memory_order_acquire);
+        const size_t used = write - m_readCache;
+        const size_t n = std::min(count, m_capacity - used);
+        copyIn(write, items, n);
+        m_write.store(write + n, std::memory_order_release);
+        if (n < count) m_overruns.fetch_add(count - n, std::memory_order_relaxed);
+        if (used + n > m_highWater.load(std::memory_order_relaxed))
+            m_highWater.store(used + n, std::memory_order_relaxed);
+        if (n > 0) {
+            m_events.fetch_add(1, std::memory_order_release);
+            m_events.notify_one();
+        }
+        return n;
+    }
+
+    // Consumer: returns how many items were taken, 0 when empty
+    size_t pop(T* out, size_t max) {
+        const size_t read = m_read.load(std::memory_order_relaxed);
+        if (m_writeCache == read)
+            m_writeCache = m_write.load(std::memory_order_acquire);
+        const size_t n = std::min(max, m_writeCache - read);
+        copyOut(read, out, n);
+        m_read.store(read + n, std::memory_order_release);
+        return n;
+    }
+
+    // Consumer: sleeps until the producer pushes something or the ring is closed. May return
+    // spuriously; callers loop over pop() anyway.
+    void wait() const {
+        const uint32_t seen = m_events.load(std::memory_order_acquire);
+        if (closed() || m_write.load(std::memory_order_acquire) != m_read.load(std::memory_order_relaxed)) return;
+        m_events.wait(seen, std::memory_order_acquire);
+    }
+    // No more pushes are coming: the consumer drains what is left and stops waiting
+    void close() {
+        m_closed.store(true, std::memory_order_release);
+        m_events.fetch_add(1, std::memory_order_release);
+        m_events.notify_all();
+    }
+    bool closed() const { return m_closed.load(std::memory_order_acquire); }
+
+    size_t size() const { return m_write.load(std::memory_order_acquire) - m_read.load(std::memory_order_acquire); }
+    uint64_t overruns() const { return m_overruns.load(std::memory_order_relaxed); }
+    size_t highWater() const { return m_highWater.load(std::memory_order_relaxed); }
+
+private:
+    void copyIn(size_t at, const T* items, size_t n) {
+        const size_t start = at & m_mask;
+        const size_t first = std::min(n, m_capacity - start);
+        std::memcpy(m_items + start, items, first * sizeof(T));
+        std::memcpy(m_items, items + first, (n - first) * sizeof(T));
+    }
+    void copyOut(size_t at, T* out, size_t n) const {
+        const size_t start = at & m_mask;
+        const size_t first = std::min(n, m_capacity - start);
+        std::memcpy(out, m_items + start, first * sizeof(T));
+        std::memcpy(out + first, m_items, (n - first) * sizeof(T));
+    }
+
+    // Read-only after construction
+    T* m_items = nullptr;
+    size_t m_capacity = 0;
+    size_t m_mask = 0;
+
+    // Producer side; indices run freely and are masked on access
+    alignas(CACHE_LINE) std::atomic<size_t> m_write{0};
+    size_t m_readCache = 0;
+    std::atomic<uint64_t> m_overruns{0};
+    std::atomic<size_t> m_highWater{0};
+
+    // Consumer side
+    alignas(CACHE_LINE) std::atomic<size_t> m_read{0};
+    size_t m_writeCache = 0;
+
+    alignas(CACHE_LINE) mutable std::atomic<uint32_t> m_events{0};
+    std::atomic<bool> m_closed{false};
+};
+
+#endif
@@ -1,11 +1,11 @@
 #include "Ultrasound.h"
 #include <algorithm>
 #include <cstddef>
+#include <cstring>
 
 namespace Ultrasound {
 
-std::vector<unsigned char> extractKeyFromMic(const std::vector<unsigned char>& micBuffer,
-                                             const std::vector<unsigned char>& headerPadding) {
+ByteSpan findKeyInMic(ByteSpan micBuffer, ByteSpan headerPadding) {
     if (headerPadding.empty() || micBuffer.size() < HEADER_SIZE + KEY_SIZE)
         return {};
 
@@ -17,22 +17,56 @@ std::vector<unsigned char> extractKeyFromMic(const std::vector<unsigned char>& m
     size_t startIdx = std::distance(micBuffer.begin(), it) + headerPadding.size();
     if (startIdx + KEY_SIZE > micBuffer.size())
         return {};
+    return micBuffer.subspan(startIdx, KEY_SIZE);
+}
+
+ByteSpan keyInFrame(ByteSpan frame, ByteSpan headerPadding) {
+    if (frame.size() <= HEADER_SIZE || frame.size() > MAX_FRAME_SIZE
+        || headerPadding.empty() || headerPadding.size() > HEADER_SIZE)
+        return {};
+    if (!std::equal(headerPadding.begin(), headerPadding.end(), frame.begin()))
+        return {};
+    const ByteSpan rest = frame.subspan(headerPadding.size(), HEADER_SIZE - headerPadding.size());
+    if (std::any_of(rest.begin(), rest.end(), [](std::byte b) { return b != std::byte{0}; }))
+        return {};
+    return frame.subspan(HEADER_SIZE);
+}
+
+size_t buildEmitPayload(ByteSpan headerPadding, ByteSpan publicKeyBytes, MutableByteSpan out) {
+    if (headerPadding.size() != HEADER_SIZE || publicKeyBytes.size() > KEY_SIZE)
+        return 0;
+    if (out.size() < TOTAL_EMIT_SIZE) return TOTAL_EMIT_SIZE;
 
-    return std::vector<unsigned char>(micBuffer.begin() + startIdx,
-                                     micBuffer.begin() + startIdx + KEY_SIZE);
+    std::memcpy(out.data(), headerPadding.data(), HEADER_SIZE);
+    if (!publicKeyBytes.empty())
+        std::memcpy(out.data() + HEADER_SIZE, publicKeyBytes.data(), publicKeyBytes.size());
+    // pad to x bytes
+    std::memset(out.data() + HEADER_SIZE + publicKeyBytes.size(), 0, KEY_SIZE - publicKeyBytes.size());
+    return TOTAL_EMIT_SIZE;
+}
+
+size_t buildFrame(ByteSpan headerPadding, ByteSpan publicKeyBytes, MutableByteSpan out) {
+    if (headerPadding.size() != HEADER_SIZE || publicKeyBytes.empty() || publicKeyBytes.size() > KEY_SIZE)
+        return 0;
+    const size_t size = HEADER_SIZE + publicKeyBytes.size();
+    if (out.size() < size) return size;
+
+    std::memcpy(out.data(), headerPadding.data(), HEADER_SIZE);
+    std::memcpy(out.data() + HEADER_SIZE, publicKeyBytes.data(), publicKeyBytes.size());
+    return size;
+}
+
+std::vector<unsigned char> extractKeyFromMic(const std::vector<unsigned char>& micBuffer,
+                                             const std::vector<unsigned char>& headerPadding) {
+    ByteSpan key = findKeyInMic(asBytes(micBuffer), asBytes(headerPadding));
+    return std::vector<unsigned char>(u8(key), u8(key) + key.size());
 }
 
 std::vector<unsigned char> buildEmitPayload(const std::vector<unsigned char>& headerPadding,
                                             const std::vector<unsigned char>& publicKeyBytes) {
-    if (headerPadding.size() != HEADER_SIZE || publicKeyBytes.size() > KEY_SIZE)
+    std::vector<unsigned char> out(TOTAL_EMIT_SIZE);
+    if (buildEmitPayload(asBytes(headerPadding), asBytes(publicKeyBytes), asWritableBytes(out)) != TOTAL_EMIT_SIZE)
         return {};
-
-    std::vector<unsigned char> out;
-    out.reserve(TOTAL_EMIT_SIZE);
-    out.insert(out.end(), headerPadding.begin(), headerPadding.end());
-    out.insert(out.end(), publicKeyBytes.begin(), publicKeyBytes.end());
-    if (out.size() < TOTAL_EMIT_SIZE)
-        out.resize(TOTAL_EMIT_SIZE, 0);  // pad to x bytes
     return out;
 }
 
@@ -1,6 +1,8 @@
 #ifndef ULTRASOUND_H
 #define ULTRASOUND_H
 
+#include "Bytes.h"
+#include <cstddef>
 #include <vector>
 
 namespace Ultrasound {
@@ -10,6 +12,8 @@ inline constexpr size_t HEADER_SIZE = 32;   // n: identifier/padding
 inline constexpr size_t KEY_SIZE = 2208;   // x - n: public key payload (e.g. 2048-bit RSA PEM ~2240, adjust as needed)
 inline constexpr size_t TOTAL_EMIT_SIZE = HEADER_SIZE + KEY_SIZE;  // x
 inline constexpr size_t MIC_BUFFER_SIZE = 2 * TOTAL_EMIT_SIZE;     // 2x
+// A modem frame carries its own length, so it holds the key unpadded: HEADER_SIZE + key size
+inline constexpr size_t MAX_FRAME_SIZE = HEADER_SIZE + KEY_SIZE;
 
 // Extract receiver's public key from mic buffer (size 2x). Searches for padding (header) and returns key bytes after it.
 std::vector<unsigned char> extractKeyFromMic(const std::vector<unsigned char>& micBuffer,
@@ -19,6 +23,16 @@ std::vector<unsigned char> extractKeyFromMic(const std::vector<unsigned char>& m
 std::vector<unsigned char> buildEmitPayload(const std::vector<unsigned char>& headerPadding,
                                             const std::vector<unsigned char>& publicKeyBytes);
 
+// Zero-copy forms: the key is returned as a view into micBuffer (empty if the header is absent);
+// the payload is written into `out` (size convention in Bytes.h)
+ByteSpan findKeyInMic(ByteSpan micBuffer, ByteSpan headerPadding);
+// A frame decoded by FskDemodulator is already aligned: the header (headerPadding, zero-filled
+// to HEADER_SIZE) must open it and the rest is the key, byte for byte. Empty when it doesn't.
+ByteSpan keyInFrame(ByteSpan frame, ByteSpan headerPadding);
+size_t buildEmitPayload(ByteSpan headerPadding, ByteSpan publicKeyBytes, MutableByteSpan out);
+// [header (n bytes)][publicKey] with no padding, for the modem; HEADER_SIZE + key size bytes
+size_t buildFrame(ByteSpan headerPadding, ByteSpan publicKeyBytes, MutableByteSpan out);
+
 } // namespace Ultrasound
 
 #endif
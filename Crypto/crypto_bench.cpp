@@ -0,0 +1,621 @@
+// Micro-benchmarks for TransactionCrypto. Each case is warmed up, then timed per operation;
+// the report (JSON on stdout) gives latency percentiles, throughput and heap allocations per
+// operation so two releases can be diffed. It also runs frames through the ultrasound modem
+// with white noise added at a range of in-band SNRs, per FEC code rate, and reports how many
+// came through and how many bytes of those were still wrong. Preamble sync is checked on
+// resampled (Doppler-shifted) frames for its timing and carrier offset error, and on frame
+// audio with the preambles cut out for false locks.
+//
+//   crypto_bench [--quick] [--filter <substring>] [--out <file.json>]
+
+#include "AES.h"
+#include "CryptoHandler.h"
+#include "Fec.h"
+#include "FskModem.h"
+#include "PhoneHash.h"
+#include "SignatureScheme.h"
+#include "SecureArena.h"
+#include "Ultrasound.h"
+#include <openssl/crypto.h>
+#include <openssl/opensslv.h>
+#include <openssl/rand.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// --- Allocation counting: C++ heap through operator new, OpenSSL through its mem hooks ---
+
+static std::atomic<uint64_t> g_heapAllocs{0};
+static std::atomic<uint64_t> g_opensslAllocs{0};
+
+void* operator new(size_t size) {
+    g_heapAllocs.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+static void* countingMalloc(size_t size, const char*, int) {
+    g_opensslAllocs.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size);
+}
+static void* countingRealloc(void* p, size_t size, const char*, int) {
+    if (!p) g_opensslAllocs.fetch_add(1, std::memory_order_relaxed);
+    return std::realloc(p, size);
+}
+static void countingFree(void* p, const char*, int) {
+    std::free(p);
+}
+
+// --- Harness ---
+
+struct Result {
+    std::string name;
+    int iterations = 0;
+    double minUs = 0, p50Us = 0, p90Us = 0, p99Us = 0, maxUs = 0, meanUs = 0;
+    double opsPerSec = 0;
+    double heapAllocsPerOp = 0;
+    double opensslAllocsPerOp = 0;
+    double secureAllocsPerOp = 0;
+};
+
+struct LinkResult {
+    std::string rate;
+    double snrDb = 0;
+    int frames = 0;
+    int delivered = 0;
+    double residualByteErrorRate = 0;   // wrong bytes over bytes in delivered frames
+    double bytesCorrectedPerFrame = 0;
+};
+
+struct SyncResult {
+    int sampleRate = 0;
+    double offsetHz = 0;                // applied carrier offset (received minus sent, band centre)
+    double snrDb = 0;
+    bool found = false;
+    double timingErrorSamples = 0;      // detected minus true start of the first data symbol
+    double offsetErrorHz = 0;
+    bool delivered = false;             // the demodulator decoded the frame intact
+};
+
+struct FalseLockResult {
+    int sampleRate = 0;
+    double seconds = 0;
+    int preambles = 0;                  // detector hits; every one is false
+    int frames = 0;                     // frames the demodulator delivered
+};
+
+struct Options {
+    bool quick = false;
+    std::string filter;
+    std::string outPath;
+};
+
+static double percentile(const std::vector<double>& sorted, double p) {
+    const size_t i = static_cast<size_t>(p * double(sorted.size() - 1) + 0.5);
+    return sorted[std::min(i, sorted.size() - 1)];
+}
+
+class Bench {
+public:
+    explicit Bench(const Options& opts) : m_opts(opts) {}
+
+    bool wants(const std::string& name) const {
+        return m_opts.filter.empty() || name.find(m_opts.filter) != std::string::npos;
+    }
+
+    // `iterations` is for a full run; --quick uses a tenth
+    void run(const std::string& name, int warmup, int iterations, const std::function<void()>& op) {
+        if (!wants(name)) return;
+        if (m_opts.quick) {
+            warmup = std::max(1, warmup / 10);
+            iterations = std::max(3, iterations / 10);
+        }
+        std::cerr << "  " << name << " (" << iterations << " iterations)..." << std::flush;
+        for (int i = 0; i < warmup; ++i) op();
+
+        std::vector<double> samples(static_cast<size_t>(iterations));
+        const uint64_t heap0 = g_heapAllocs.load();
+        const uint64_t ossl0 = g_opensslAllocs.load();
+        const uint64_t secure0 = SecureArena::instance().stats().allocations;
+        for (double& us : samples) {
+            const auto start = std::chrono::steady_clock::now();
+            op();
+            us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        }
+        const double n = double(iterations);
+        Result r;
+        r.name = name;
+        r.iterations = iterations;
+        // Reading the counters costs nothing; the samples vector was allocated beforehand
+        r.heapAllocsPerOp = double(g_heapAllocs.load() - heap0) / n;
+        r.opensslAllocsPerOp = double(g_opensslAllocs.load() - ossl0) / n;
+        r.secureAllocsPerOp = double(SecureArena::instance().stats().allocations - secure0) / n;
+
+        double total = 0;
+        for (double us : samples) total += us;
+        std::sort(samples.begin(), samples.end());
+        r.minUs = samples.front();
+        r.maxUs = samples.back();
+        r.p50Us = percentile(samples, 0.50);
+        r.p90Us = percentile(samples, 0.90);
+        r.p99Us = percentile(samples, 0.99);
+        r.meanUs = total / n;
+        r.opsPerSec = total > 0 ? 1e6 * n / total : 0;
+        std::cerr << " p50 " << r.p50Us << " us\n";
+        m_results.push_back(r);
+    }
+
+    void addLink(const LinkResult& r) { m_links.push_back(r); }
+    void addSync(const SyncResult& r) { m_syncs.push_back(r); }
+    void addFalseLock(const FalseLockResult& r) { m_falseLocks.push_back(r); }
+
+    std::string json(bool opensslHooked) const {
+        std::ostringstream out;
+        out.precision(6);
+        out << "{\n  \"openssl\": \"" << OPENSSL_VERSION_TEXT << "\",\n"
+            << "  \"mode\": \"" << (m_opts.quick ? "quick" : "full") << "\",\n"
+            << "  \"openssl_allocs_counted\": " << (opensslHooked ? "true" : "false") << ",\n"
+            << "  \"results\": [\n";
+        for (size_t i = 0; i < m_results.size(); ++i) {
+            const Result& r = m_results[i];
+            out << "    {\"name\": \"" << r.name << "\", \"iterations\": " << r.iterations
+                << ", \"min_us\": " << r.minUs << ", \"p50_us\": " << r.p50Us
+                << ", \"p90_us\": " << r.p90Us << ", \"p99_us\": " << r.p99Us
+                << ", \"max_us\": " << r.maxUs << ", \"mean_us\": " << r.meanUs
+                << ", \"ops_per_sec\": " << r.opsPerSec
+                << ", \"heap_allocs_per_op\": " << r.heapAllocsPerOp
+                << ", \"openssl_allocs_per_op\": " << r.opensslAllocsPerOp
+                << ", \"secure_allocs_per_op\": " << r.secureAllocsPerOp << "}"
+                << (i + 1 < m_results.size() ? ",\n" : "\n");
+        }
+        out << "  ],\n  \"fec_link\": [\n";
+        for (size_t i = 0; i < m_links.size(); ++i) {
+            const LinkResult& r = m_links[i];
+            out << "    {\"rate\": \"" << r.rate << "\", \"snr_db\": " << r.snrDb
+                << ", \"frames\": " << r.frames << ", \"delivered\": " << r.delivered
+                << ", \"frame_error_rate\": " << (r.frames ? 1.0 - double(r.delivered) / r.frames : 0.0)
+                << ", \"residual_byte_error_rate\": " << r.residualByteErrorRate
+                << ", \"bytes_corrected_per_frame\": " << r.bytesCorrectedPerFrame << "}"
+                << (i + 1 < m_links.size() ? ",\n" : "\n");
+        }
+        out << "  ],\n  \"preamble_sync\": [\n";
+        for (size_t i = 0; i < m_syncs.size(); ++i) {
+            const SyncResult& r = m_syncs[i];
+            out << "    {\"sample_rate\": " << r.sampleRate << ", \"offset_hz\": " << r.offsetHz
+                << ", \"snr_db\": " << r.snrDb
+                << ", \"found\": " << (r.found ? "true" : "false")
+                << ", \"timing_error_samples\": " << r.timingErrorSamples
+                << ", \"offset_error_hz\": " << r.offsetErrorHz
+                << ", \"delivered\": " << (r.delivered ? "true" : "false") << "}"
+                << (i + 1 < m_syncs.size() ? ",\n" : "\n");
+        }
+        out << "  ],\n  \"false_lock\": [\n";
+        for (size_t i = 0; i < m_falseLocks.size(); ++i) {
+            const FalseLockResult& r = m_falseLocks[i];
+            out << "    {\"sample_rate\": " << r.sampleRate << ", \"seconds\": " << r.seconds
+                << ", \"false_preambles\": " << r.preambles << ", \"false_frames\": " << r.frames << "}"
+                << (i + 1 < m_falseLocks.size() ? ",\n" : "\n");
+        }
+        out << "  ]\n}\n";
+        return out.str();
+    }
+
+private:
+    Options m_opts;
+    std::vector<Result> m_results;
+    std::vector<LinkResult> m_links;
+    std::vector<SyncResult> m_syncs;
+    std::vector<FalseLockResult> m_falseLocks;
+};
+
+// The optimizer must not drop a result it can see is unused. The sink is read back as well
+// (a volatile read), so it doesn't count as set-but-unused.
+static void keep(size_t v) {
+    static volatile size_t sink;
+    sink = v;
+    (void)sink;
+}
+
+// Soft bits for a coded frame as a demodulator might hand them over: right on average, with
+// enough noise that some come out wrong
+static std::vector<Ultrasound::Fec::SoftBit> noisySoftBits(const std::vector<uint8_t>& symbols, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> noise(0.0f, 24.0f);
+    std::vector<Ultrasound::Fec::SoftBit> soft(symbols.size() * Ultrasound::Fec::SOFT_BITS_PER_SYMBOL);
+    for (size_t i = 0; i < soft.size(); ++i) {
+        const float v = ((symbols[i / 8] >> (i % 8)) & 1 ? -40.0f : 40.0f) + noise(rng);
+        soft[i] = Ultrasound::Fec::SoftBit(std::lrint(std::clamp(v, -127.0f, 127.0f)));
+    }
+    return soft;
+}
+
+// Sigma of white noise putting the data tones snrDb above the noise within the modem band
+static float noiseSigma(const Ultrasound::ModemParams& params, double snrDb) {
+    const double band = params.chirpHighHz() - params.chirpLowHz();
+    const double signal = double(Ultrasound::FskModulator::AMPLITUDE) * Ultrasound::FskModulator::AMPLITUDE;
+    return float(std::sqrt(signal / std::pow(10.0, snrDb / 10) / (band / (params.sampleRate / 2.0))));
+}
+
+// Sends `frames` copies of the payload over white noise at snrDb (data tones' power over the
+// noise's within the modem band) and counts what the demodulator delivers
+static LinkResult runLink(Ultrasound::Fec::CodeRate rate, const char* rateName, double snrDb, int frames,
+                          const std::vector<unsigned char>& payload) {
+    using namespace Ultrasound;
+    const ModemParams params = ModemParams::forSampleRate(48000);
+    FskModulator modulator(params);
+    modulator.setPayload(payload.data(), payload.size(), true, rate);
+    const float sigma = noiseSigma(params, snrDb);
+
+    LinkResult r;
+    r.rate = rateName;
+    r.snrDb = snrDb;
+    r.frames = frames;
+    size_t wrong = 0;
+    FskDemodulator demodulator(params, payload.size(), [&](const unsigned char* data, size_t size) {
+        ++r.delivered;
+        for (size_t i = 0; i < std::min(size, payload.size()); ++i) wrong += data[i] != payload[i];
+        wrong += size > payload.size() ? size - payload.size() : payload.size() - size;
+    });
+
+    // Noise alone before the first preamble, and long enough after the last frame to decode it
+    std::mt19937 rng(uint32_t(1000 + snrDb * 10) + uint32_t(rate));
+    std::normal_distribution<float> noise(0.0f, sigma);
+    const size_t lead = size_t(params.sampleRate) / 5;
+    const size_t total = 2 * lead + size_t(std::ceil(frames * modulator.frameSeconds() * params.sampleRate));
+    std::vector<float> block(480);
+    for (size_t done = 0; done < total; done += block.size()) {
+        const size_t n = std::min(block.size(), total - done);
+        size_t at = 0;
+        if (done < lead) {
+            at = std::min(n, lead - done);
+            std::fill(block.begin(), block.begin() + ptrdiff_t(at), 0.0f);
+        }
+        modulator.render(block.data() + at, n - at);
+        for (size_t i = 0; i < n; ++i) block[i] += noise(rng);
+        demodulator.process(block.data(), n);
+    }
+    r.residualByteErrorRate = r.delivered ? double(wrong) / (double(r.delivered) * payload.size()) : 0.0;
+    r.bytesCorrectedPerFrame = r.delivered ? double(demodulator.bytesCorrected()) / r.delivered : 0.0;
+    std::cerr << "  fec_link " << rateName << " @ " << snrDb << " dB: " << r.delivered << "/" << frames << "\n";
+    return r;
+}
+
+// What a receiver hears when every frequency is scaled by `ratio` (Doppler, or the two sound
+// cards' clocks disagreeing): out[n] = in(n * ratio), by Blackman-windowed sinc interpolation
+static std::vector<float> resample(const std::vector<float>& in, double ratio) {
+    constexpr int HALF = 64;    // a shorter kernel dulls the band's top edge at 44.1 kHz and biases the peaks
+    const double pi = std::acos(-1.0);
+    std::vector<float> out(size_t(double(in.size() - 1) / ratio));
+    for (size_t n = 0; n < out.size(); ++n) {
+        const double t = double(n) * ratio;
+        const auto base = ptrdiff_t(std::floor(t));
+        // sin(pi * x) only flips sign from one tap to the next
+        double s = std::sin(pi * (t - double(base - HALF + 1)));
+        double acc = 0;
+        for (ptrdiff_t k = base - HALF + 1; k <= base + HALF; ++k, s = -s) {
+            if (k < 0 || k >= ptrdiff_t(in.size())) continue;
+            const double x = t - double(k);
+            const double sinc = std::abs(x) < 1e-9 ? 1.0 : s / (pi * x);
+            const double w = 0.42 + 0.5 * std::cos(pi * x / HALF) + 0.08 * std::cos(2 * pi * x / HALF);
+            acc += in[size_t(k)] * sinc * w;
+        }
+        out[n] = float(acc);
+    }
+    return out;
+}
+
+// One frame after a stretch of silence, resampled for a carrier offset of offsetHz at the band
+// centre, with noise at snrDb. The detector's first hit is compared with where the first data
+// symbol really starts, and a demodulator is run over the same audio.
+static SyncResult runSync(int sampleRate, double offsetHz, double snrDb, const std::vector<unsigned char>& payload) {
+    using namespace Ultrasound;
+    const ModemParams params = ModemParams::forSampleRate(sampleRate);
+    FskModulator modulator(params);
+    modulator.setPayload(payload.data(), payload.size(), false);
+    const size_t lead = size_t(sampleRate) / 5 + 123;   // off the detector's block grid
+    std::vector<float> sent(lead + size_t(std::ceil(modulator.frameSeconds() * sampleRate)) + size_t(sampleRate) / 5, 0.0f);
+    modulator.render(sent.data() + lead, sent.size() - lead);
+
+    const double ratio = 1.0 + offsetHz / params.centreHz();
+    std::vector<float> heard = resample(sent, ratio);
+    std::mt19937 rng(uint32_t(sampleRate) + uint32_t(offsetHz + 1000));
+    std::normal_distribution<float> noise(0.0f, noiseSigma(params, snrDb));
+    for (float& x : heard) x += noise(rng);
+
+    SyncResult r;
+    r.sampleRate = sampleRate;
+    r.offsetHz = offsetHz;
+    r.snrDb = snrDb;
+    ChirpDetector detector(params);
+    ChirpDetector::Hit hit;
+    for (float x : heard) {
+        if (detector.push(x, hit)) {
+            r.found = true;
+            break;
+        }
+    }
+    if (r.found) {
+        const double dataStart = double(lead + PREAMBLE_SYMBOLS * size_t(params.symbolSamples)) / ratio;
+        r.timingErrorSamples = hit.position - dataStart;
+        r.offsetErrorHz = hit.frequencyOffsetHz - offsetHz;
+    }
+    FskDemodulator demodulator(params, payload.size(), [&](const unsigned char* data, size_t size) {
+        r.delivered = r.delivered || (size == payload.size() && std::equal(payload.begin(), payload.end(), data));
+    });
+    demodulator.process(heard.data(), heard.size());
+    std::cerr << "  preamble_sync " << sampleRate << " Hz @ " << offsetHz << " Hz: "
+              << (r.found ? "timing " + std::to_string(r.timingErrorSamples) + ", offset " + std::to_string(r.offsetErrorHz)
+                          : std::string("not found")) << "\n";
+    return r;
+}
+
+// `seconds` of frame audio (fresh random payloads, silent gaps kept) with every preamble cut
+// out, plus noise at snrDb. Nothing in it is a frame, so every detector hit and every frame
+// the demodulator delivers is a false lock.
+static FalseLockResult runFalseLock(int sampleRate, double seconds, double snrDb) {
+    using namespace Ultrasound;
+    const ModemParams params = ModemParams::forSampleRate(sampleRate);
+    const size_t preamble = PREAMBLE_SYMBOLS * size_t(params.symbolSamples);
+    std::mt19937 rng(uint32_t(sampleRate) * 7u);
+    std::normal_distribution<float> noise(0.0f, noiseSigma(params, snrDb));
+    std::uniform_int_distribution<int> byte(0, 255);
+
+    FalseLockResult r;
+    r.sampleRate = sampleRate;
+    r.seconds = seconds;
+    ChirpDetector detector(params);
+    ChirpDetector::Hit hit;
+    FskDemodulator demodulator(params, MAX_FRAME_PAYLOAD, [&](const unsigned char*, size_t) { ++r.frames; });
+    FskModulator modulator(params);
+    std::vector<unsigned char> payload(128);
+    std::vector<float> audio;
+    const size_t total = size_t(seconds * sampleRate);
+    for (size_t done = 0; done < total;) {
+        for (unsigned char& b : payload) b = (unsigned char)byte(rng);
+        modulator.setPayload(payload.data(), payload.size(), false);
+        audio.resize(modulator.frameSymbols() * size_t(params.symbolSamples));
+        audio.resize(modulator.render(audio.data(), audio.size()));
+        audio.erase(audio.begin(), audio.begin() + ptrdiff_t(std::min(preamble, audio.size())));
+        audio.resize(std::min(audio.size(), total - done));
+        for (float& x : audio) {
+            x += noise(rng);
+            if (detector.push(x, hit)) ++r.preambles;
+        }
+        demodulator.process(audio.data(), audio.size());
+        done += audio.size();
+    }
+    std::cerr << "  false_lock " << sampleRate << " Hz, " << seconds << " s: " << r.preambles
+              << " preambles, " << r.frames << " frames\n";
+    return r;
+}
+
+int main(int argc, char** argv) {
+    // Must precede every OpenSSL allocation
+    const bool opensslHooked = CRYPTO_set_mem_functions(countingMalloc, countingRealloc, countingFree) == 1;
+
+    Options opts;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--quick") == 0) opts.quick = true;
+        else if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) opts.filter = argv[++i];
+        else if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc) opts.outPath = argv[++i];
+        else {
+            std::cerr << "usage: " << argv[0] << " [--quick] [--filter <substring>] [--out <file.json>]\n";
+            return 2;
+        }
+    }
+
+    // Fixtures
+    const std::string message = "sender@fastpay|merchant@fastpay|100.00|2026-01-01 12:00:00";
+    std::string rsaPub, ecPub;
+    SecureString rsaPriv, ecPriv;
+    CryptoHandler::generateKeyPair(rsaPub, rsaPriv);
+    DigitalSignature::generateKeyPair(ecPub, ecPriv);
+    const std::vector<unsigned char> rsaCipher = CryptoHandler::encrypt(message, rsaPub);
+    const std::vector<unsigned char> ecSig = DigitalSignature::signTransaction(message, ecPriv);
+    const DigitalSignature::SigningKey ecSigner(ecPriv);
+    const DigitalSignature::VerifyingKey ecVerifier(ecPub);
+
+    std::vector<unsigned char> aesKey(32), aesNonce(12);
+    RAND_bytes(aesKey.data(), int(aesKey.size()));
+    RAND_bytes(aesNonce.data(), int(aesNonce.size()));
+    std::vector<float> samples(2048);
+    for (size_t i = 0; i < samples.size(); ++i) samples[i] = float(i % 64) / 64.0f;
+    const std::vector<unsigned char> aesSealed = prepareAndEncrypt(42, samples, aesKey);
+
+    std::vector<unsigned char> header(Ultrasound::HEADER_SIZE, 0);
+    std::memcpy(header.data(), "FASTPAY_ONLINE_V1", 17);
+    const std::vector<unsigned char> keyBytes(rsaPub.begin(), rsaPub.end());
+    const std::vector<unsigned char> emit = Ultrasound::buildEmitPayload(header, keyBytes);
+    // Worst realistic case: the frame starts late in the 2x capture window
+    std::vector<unsigned char> mic(Ultrasound::MIC_BUFFER_SIZE, 0);
+    std::memcpy(mic.data() + Ultrasound::TOTAL_EMIT_SIZE - 1, emit.data(), emit.size());
+    if (rsaCipher.empty() || ecSig.empty() || aesSealed.empty() || emit.empty()) {
+        std::cerr << "fixture setup failed\n";
+        return 1;
+    }
+
+    // A merchant contact book, formatted the way phones store numbers
+    std::vector<std::string> contacts(50000);
+    for (size_t i = 0; i < contacts.size(); ++i)
+        contacts[i] = "+91 98" + std::to_string(100000 + i * 7) + "-" + std::to_string(10 + i % 90);
+    const std::vector<std::string_view> contactViews(contacts.begin(), contacts.end());
+    std::vector<unsigned char> contactKeys(contacts.size() * PhoneHash::KEY_SIZE);
+
+    // One audio callback's worth (10 ms at 48 kHz) of the modulated emit frame
+    Ultrasound::FskModulator modulator(Ultrasound::ModemParams::forSampleRate(48000));
+    modulator.setPayload(emit.data(), emit.size());
+    std::vector<float> audioF(480);
+    std::vector<int16_t> audioS(480);
+    // A second of received audio, fed to the demodulator one 10 ms capture block at a time
+    std::vector<float> micAudio(48000);
+    {
+        Ultrasound::FskModulator source(modulator.params());
+        source.setPayload(emit.data(), emit.size());
+        source.render(micAudio.data(), micAudio.size());
+    }
+    size_t micPos = 0;
+    Ultrasound::FskDemodulator demodulator(modulator.params(), Ultrasound::TOTAL_EMIT_SIZE, nullptr);
+
+    // The emit frame coded at each rate, decoded from noisy soft bits as the demodulator does
+    struct CodedEmit {
+        const char* name;
+        Ultrasound::Fec::CodeRate rate;
+        std::vector<Ultrasound::Fec::SoftBit> soft;
+    };
+    std::vector<CodedEmit> codedEmits = {{"1_2", Ultrasound::Fec::CodeRate::Half, {}},
+                                         {"2_3", Ultrasound::Fec::CodeRate::TwoThirds, {}},
+                                         {"3_4", Ultrasound::Fec::CodeRate::ThreeQuarters, {}}};
+    for (CodedEmit& c : codedEmits)
+        c.soft = noisySoftBits(Ultrasound::Fec::encodeFrame(emit.data(), emit.size(), c.rate), 7);
+    Ultrasound::Fec::FrameDecoder frameDecoder(Ultrasound::TOTAL_EMIT_SIZE);
+    std::vector<unsigned char> decoded(Ultrasound::TOTAL_EMIT_SIZE);
+
+    std::vector<unsigned char> sigBuf(DigitalSignature::P256::maxSignatureSize);
+    std::vector<unsigned char> ctBuf(4096), ptBuf(4096);
+
+    std::cerr << "crypto_bench (" << OPENSSL_VERSION_TEXT << ")\n";
+    Bench bench(opts);
+
+    bench.run("rsa2048_generate_key_pair", 1, 20, [] {
+        std::string pub;
+        SecureString priv;
+        CryptoHandler::generateKeyPair(pub, priv);
+        keep(priv.size());
+    });
+    bench.run("ec_p256_generate_key_pair", 20, 500, [] {
+        std::string pub;
+        SecureString priv;
+        DigitalSignature::generateKeyPair(pub, priv);
+        keep(priv.size());
+    });
+
+    bench.run("ecdsa_sign_transaction", 50, 2000, [&] {
+        keep(DigitalSignature::signTransaction(message, ecPriv).size());
+    });
+    bench.run("ecdsa_sign_parsed_key_span", 50, 2000, [&] {
+        keep(ecSigner.sign(asBytes(message), asWritableBytes(sigBuf)));
+    });
+    bench.run("ecdsa_verify_signature", 50, 2000, [&] {
+        keep(DigitalSignature::verifySignature(message, ecSig, ecPub));
+    });
+    bench.run("ecdsa_verify_parsed_key_span", 50, 2000, [&] {
+        keep(ecVerifier.verify(asBytes(message), asBytes(ecSig)));
+    });
+
+    bench.run("rsa_oaep_encrypt", 50, 2000, [&] {
+        keep(CryptoHandler::encrypt(message, rsaPub).size());
+    });
+    bench.run("rsa_oaep_encrypt_span", 50, 2000, [&] {
+        keep(CryptoHandler::encrypt(asBytes(message), rsaPub, asWritableBytes(ctBuf)));
+    });
+    bench.run("rsa_oaep_decrypt", 20, 500, [&] {
+        keep(CryptoHandler::decrypt(rsaCipher, rsaPriv).size());
+    });
+    bench.run("rsa_oaep_decrypt_span", 20, 500, [&] {
+        keep(CryptoHandler::decrypt(asBytes(rsaCipher), rsaPriv, asWritableBytes(ptBuf)));
+    });
+
+    bench.run("aes_gcm_encrypt", 200, 10000, [&] {
+        keep(aesEncrypt(message, aesKey, aesNonce).size());
+    });
+    AeadStream aesStream(aesKey.data());
+    bench.run("aes_gcm_encrypt_caller_stream", 200, 10000, [&] {
+        keep(aesEncrypt(aesStream, asBytes(message), asBytes(aesNonce), asWritableBytes(ctBuf)));
+    });
+    bench.run("aes_gcm_prepare_and_encrypt_8k", 100, 5000, [&] {
+        keep(prepareAndEncrypt(42, samples, aesKey).size());
+    });
+    bench.run("aes_gcm_decrypt_embedded_iv_8k", 100, 5000, [&] {
+        keep(aesDecryptWithEmbeddedIV(aesSealed, aesKey).size());
+    });
+
+    bench.run("ultrasound_extract_key_from_mic", 100, 5000, [&] {
+        keep(Ultrasound::extractKeyFromMic(mic, header).size());
+    });
+    bench.run("ultrasound_find_key_in_mic_span", 100, 5000, [&] {
+        keep(Ultrasound::findKeyInMic(asBytes(mic), asBytes(header)).size());
+    });
+
+    bench.run("phone_hash_single", 200, 10000, [&] {
+        unsigned char key[PhoneHash::KEY_SIZE];
+        keep(PhoneHash::hash(contacts[7], key));
+    });
+    bench.run("phone_hash_batch_50k", 2, 30, [&] {
+        keep(PhoneHash::hashBatch(contactViews.data(), contactViews.size(), contactKeys.data()).size());
+    });
+
+    bench.run("fsk_render_10ms_float", 200, 10000, [&] {
+        keep(modulator.render(audioF.data(), audioF.size()));
+    });
+    bench.run("fsk_render_10ms_int16", 200, 10000, [&] {
+        keep(modulator.render(audioS.data(), audioS.size()));
+    });
+    bench.run("fsk_demod_10ms", 200, 10000, [&] {
+        demodulator.process(micAudio.data() + micPos, 480);
+        micPos = (micPos + 480) % micAudio.size();
+        keep(demodulator.locked());
+    });
+    for (const CodedEmit& c : codedEmits) {
+        bench.run(std::string("fec_decode_emit_frame_rate") + c.name, 2, 50, [&] {
+            Ultrasound::Fec::Header h;
+            if (!frameDecoder.decodeHeader(c.soft.data(), h)) return;
+            keep(size_t(frameDecoder.decodeBody(c.soft.data() + Ultrasound::Fec::HEADER_SYMBOLS * Ultrasound::Fec::SOFT_BITS_PER_SYMBOL,
+                                                     h, decoded.data())));
+        });
+    }
+
+    if (bench.wants("fec_link")) {
+        std::vector<unsigned char> linkPayload(128);
+        for (size_t i = 0; i < linkPayload.size(); ++i) linkPayload[i] = (unsigned char)(i * 37 + 11);
+        const int frames = opts.quick ? 2 : 10;
+        for (const CodedEmit& c : codedEmits)
+            for (double snrDb = -8; snrDb <= 0; snrDb += 2)
+                bench.addLink(runLink(c.rate, c.name, snrDb, frames, linkPayload));
+    }
+
+    // For the sync claims: timing within 0.1 sample and offset within ~3 Hz over -150..+100 Hz
+    // at 48 and 44.1 kHz (on a clean link; noise adds its own jitter), and no lock on frame
+    // data without its preamble
+    if (bench.wants("preamble_sync")) {
+        std::vector<unsigned char> syncPayload(64);
+        for (size_t i = 0; i < syncPayload.size(); ++i) syncPayload[i] = (unsigned char)(i * 53 + 7);
+        for (int rate : {48000, 44100})
+            for (double offsetHz = -150; offsetHz <= 100; offsetHz += opts.quick ? 125 : 50)
+                bench.addSync(runSync(rate, offsetHz, 30.0, syncPayload));
+    }
+    if (bench.wants("false_lock")) {
+        for (int rate : {48000, 44100})
+            bench.addFalseLock(runFalseLock(rate, opts.quick ? 6.0 : 60.0, 10.0));
+    }
+
+    const std::string report = bench.json(opensslHooked);
+    if (opts.outPath.empty()) {
+        std::cout << report;
+    } else {
+        std::ofstream out(opts.outPath);
+        out << report;
+        if (!out) {
+            std::cerr << "could not write " << opts.outPath << "\n";
+            return 1;
+        }
+        std::cerr << "wrote " << opts.outPath << "\n";
+    }
+    return 0;
+}
@@ -1,73 +1,74 @@
 #include "CryptoHandler.h"
 #include "Ultrasound.h"
 #include "DigitalSignature.h"
+#include "PinKdf.h"
+#include "KeyCache.h"
+#include "SignatureScheme.h"
+#include "KeyPairPool.h"
+#include <openssl/rand.h>
+#include <cstdio>
+#include <thread>
 #include <iostream>
 #include <string>
 #include <vector>
 #include <cstring>
+#include <algorithm>
+#include <chrono>
 
-// --- Online flow (receiver emits ultrasound public key; sender captures 2x, extracts key, initiates with PIN) ---
+// --- Online flow (receiver emits ultrasound public key; sender decodes the frame, extracts key, initiates with PIN) ---
 int runOnlineFlow() {
-    std::string receiverPubKey, receiverPrivKey;
-    CryptoHandler::generateKeyPair(receiverPubKey, receiverPrivKey);
+    // X25519 hybrid: the receiver broadcasts a 32-byte key instead of an RSA PEM
+    std::vector<unsigned char> receiverPubKey;
+    SecureString receiverPrivKey;
+    CryptoHandler::generateHybridKeyPair(receiverPubKey, receiverPrivKey);
 
-    // Receiver: build ultrasound payload [header (n)][public key (x-n)] = x
+    // Receiver: build the modem frame [header (n)][public key], unpadded: the FEC header
+    // carries the length
     std::vector<unsigned char> header(Ultrasound::HEADER_SIZE, 0);
     const char* ident = "FASTPAY_ONLINE_V1";
     size_t idLen = std::strlen(ident);
     if (idLen > header.size()) idLen = header.size();
     std::memcpy(header.data(), ident, idLen);
 
-    std::vector<unsigned char> pubKeyBytes(receiverPubKey.begin(), receiverPubKey.end());
-    if (pubKeyBytes.size() > Ultrasound::KEY_SIZE) pubKeyBytes.resize(Ultrasound::KEY_SIZE);
-    std::vector<unsigned char> emitPayload = Ultrasound::buildEmitPayload(header, pubKeyBytes);
-    if (emitPayload.empty()) {
-        std::cerr << "Failed to build emit payload\n";
+    std::vector<unsigned char> frame(Ultrasound::HEADER_SIZE + receiverPubKey.size());
+    if (Ultrasound::buildFrame(asBytes(header), asBytes(receiverPubKey), asWritableBytes(frame)) != frame.size()) {
+        std::cerr << "Failed to build emit frame\n";
         return -1;
     }
-    std::cout << "Receiver: emitting " << emitPayload.size() << " bytes (header + pubkey)\n";
+    std::cout << "Receiver: emitting " << frame.size() << " bytes (header + "
+              << receiverPubKey.size() << "-byte pubkey)\n";
 
-    // Sender: simulate mic buffer 2x (in real app, fill from mic)
-    std::vector<unsigned char> micBuffer(2 * emitPayload.size(), 0);
-    size_t offset = 0;
-    if (micBuffer.size() >= emitPayload.size())
-        std::memcpy(micBuffer.data() + offset, emitPayload.data(), emitPayload.size());
-
-    std::vector<unsigned char> extractedKey = Ultrasound::extractKeyFromMic(micBuffer, header);
-    if (extractedKey.empty()) {
-        std::cerr << "Sender: could not extract key from mic buffer\n";
+    // Sender: the demodulator hands over the decoded frame, aligned on the preamble (simulated here)
+    const ByteSpan key = Ultrasound::keyInFrame(asBytes(frame), asBytes(header));
+    if (key.size() != CryptoHandler::X25519_KEY_SIZE) {
+        std::cerr << "Sender: could not extract key from the received frame\n";
         return -1;
     }
-    // Trim to valid PEM (in case of padding zeros)
-    std::string keyStr(extractedKey.begin(), extractedKey.end());
-    size_t endMark = keyStr.find("-----END PUBLIC KEY-----");
-    if (endMark != std::string::npos)
-        keyStr = keyStr.substr(0, endMark + 24);
-    std::string senderExtractedPubKey = keyStr;
-
-    // Sender: build transaction payload (e.g. UPI ID + amount + nonce) and encrypt with receiver's public key
+    const std::vector<unsigned char> extractedKey(u8(key), u8(key) + key.size());
+
+    // Sender: build transaction payload (e.g. UPI ID + amount + nonce) and encrypt to the receiver's key
     std::string nonce = DigitalSignature::getTimestampNonceString();
     std::string upiId = "sender@fastpay";
     std::string amount = "100.00";
     std::string payload = upiId + "|" + amount + "|" + nonce;
 
-    std::vector<unsigned char> encrypted = CryptoHandler::encrypt(payload, senderExtractedPubKey);
+    std::vector<unsigned char> encrypted = CryptoHandler::hybridEncrypt(payload, extractedKey);
     if (encrypted.empty()) {
-        std::cerr << "Sender: encryption failed (key may be truncated)\n";
+        std::cerr << "Sender: encryption failed\n";
         return -1;
     }
     std::cout << "Sender: encrypted payload size " << encrypted.size() << " bytes. Initiate online with PIN.\n";
 
     // Server/receiver: decrypt (simulated here)
-    std::string decrypted = CryptoHandler::decrypt(encrypted, receiverPrivKey);
+    std::string decrypted = CryptoHandler::hybridDecrypt(encrypted, receiverPrivKey);
     std::cout << "Receiver/Server: transaction received: " << decrypted << std::endl;
     return 0;
 }
 
 // --- Offline flow (cold wallet to cold wallet: sender signs, receiver verifies and sends receipt; sync when online) ---
 int runOfflineFlow() {
-    std::string senderPubKey, senderPrivKey;
-    std::string receiverPubKey, receiverPrivKey;
+    std::string senderPubKey, receiverPubKey;
+    SecureString senderPrivKey, receiverPrivKey;
     DigitalSignature::generateKeyPair(senderPubKey, senderPrivKey);
     DigitalSignature::generateKeyPair(receiverPubKey, receiverPrivKey);
 
@@ -101,7 +102,189 @@ int runOfflineFlow() {
     return 0;
 }
 
-int main() {
+// --- PIN KDF cost: verification latency of each device preset on this machine ---
+int runPinKdfBenchmark() {
+    std::cout << "PBKDF2-HMAC-SHA256, one PIN verification:\n";
+    for (const PinKdf::DevicePreset& preset : PinKdf::DEVICE_PRESETS) {
+        double best = PinKdf::measure(preset.iterations);
+        for (int i = 0; i < 2; ++i)
+            best = std::min(best, PinKdf::measure(preset.iterations));
+        std::cout << "  " << preset.name << " (" << preset.iterations << " iterations): "
+                  << best << " ms\n";
+    }
+    std::cout << "  calibrated for 250 ms here: " << PinKdf::calibrate(250.0) << " iterations\n";
+    return 0;
+}
+
+// --- Batch verification throughput: a settlement backlog from a few hundred counterparties ---
+int runVerifyBenchmark() {
+    const size_t signers = 200, count = 8192;
+    std::vector<std::string> pubKeys(signers);
+    std::vector<std::string> messages(count);
+    std::vector<std::vector<unsigned char>> signatures(count);
+    for (size_t k = 0; k < signers; ++k) {
+        SecureString privKey;
+        DigitalSignature::generateKeyPair(pubKeys[k], privKey);
+        DigitalSignature::SigningKey signer(privKey);
+        for (size_t i = k; i < count; i += signers) {
+            messages[i] = "sender" + std::to_string(k) + "@fastpay|merchant@fastpay|"
+                          + std::to_string(i) + ".00|" + DigitalSignature::getTimestampNonceString();
+            signatures[i] = signer.sign(messages[i]);
+        }
+    }
+    std::vector<DigitalSignature::VerifyItem> items(count);
+    for (size_t i = 0; i < count; ++i)
+        items[i] = { messages[i].data(), messages[i].size(), signatures[i].data(), signatures[i].size(),
+                     &pubKeys[i % signers] };
+
+    std::cout << "verifyBatch, " << count << " ECDSA P-256 signatures from " << signers << " signers:\n";
+    for (unsigned threads : { 1u, 2u, 4u, 8u }) {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<uint64_t> bitmap = DigitalSignature::verifyBatch(items, threads);
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        size_t valid = 0;
+        for (size_t i = 0; i < count; ++i)
+            valid += DigitalSignature::batchResult(bitmap, i);
+        std::cout << "  " << threads << " thread(s): " << static_cast<long>(count / secs)
+                  << " verifications/s (" << valid << "/" << count << " valid)\n";
+    }
+    KeyCache::Stats keys = KeyCache::instance().stats();
+    std::cout << "  key cache: " << keys.hits << " hits, " << keys.misses << " misses, "
+              << keys.size << "/" << keys.capacity << " entries\n";
+    return 0;
+}
+
+// --- Signature schemes side by side: sizes matter on the ultrasound link, speed at settlement ---
+template <typename Policy>
+void benchScheme() {
+    using Scheme = DigitalSignature::SignatureScheme<Policy>;
+    const int rounds = 2000;
+    std::string pubKey;
+    SecureString privKey;
+    Scheme::generateKeyPair(pubKey, privKey);
+    typename Scheme::SigningKey signer(privKey);
+    typename Scheme::VerifyingKey verifier(pubKey);
+    const std::string message = "cold_sender@fastpay|cold_receiver@fastpay|50.00|"
+                                + DigitalSignature::getTimestampNonceString();
+
+    std::vector<unsigned char> sig;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i)
+        sig = signer.sign(message);
+    auto signed_ = std::chrono::steady_clock::now();
+    int valid = 0;
+    for (int i = 0; i < rounds; ++i)
+        valid += verifier.verify(message, sig);
+    auto verified = std::chrono::steady_clock::now();
+
+    auto usPerOp = [rounds](auto from, auto to) {
+        return std::chrono::duration<double, std::micro>(to - from).count() / rounds;
+    };
+    std::cout << "  " << Scheme::name() << ": sign " << usPerOp(start, signed_) << " us, verify "
+              << usPerOp(signed_, verified) << " us, signature " << sig.size() << " bytes, "
+              << "public key PEM " << pubKey.size() << " bytes (" << valid << "/" << rounds << " valid)\n";
+}
+
+int runSchemeBenchmark() {
+    std::cout << "Signature schemes (per operation, parsed keys reused):\n";
+    benchScheme<DigitalSignature::P256>();
+    benchScheme<DigitalSignature::Ed25519>();
+    return 0;
+}
+
+// --- Key-pair pool: depth and refill rate against an onboarding burst, reload from disk ---
+int runKeyPoolBenchmark() {
+    const size_t target = 8;
+    const char* path = "keypool_bench.bin";
+    unsigned char storageKey[KeyPairPool::STORAGE_KEY_SIZE];
+    if (RAND_bytes(storageKey, sizeof(storageKey)) != 1) return -1;
+    std::remove(path);
+
+    auto start = std::chrono::steady_clock::now();
+    std::string pubKey;
+    SecureString privKey;
+    CryptoHandler::generateKeyPair(pubKey, privKey);
+    std::cout << "RSA-2048 generated inline: "
+              << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+              << " ms\n";
+
+    {
+        KeyPairPool pool(&CryptoHandler::generateKeyPair, target, path, storageKey);
+        while (pool.stats().depth < target)
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        KeyPairPool::Stats s = pool.stats();
+        std::cout << "pool filled to " << s.depth << ": " << s.averageGenerateMs << " ms per key, "
+                  << s.refillPerSecond << " keys/s refill\n";
+
+        // Burst of twice the pool depth, back to back
+        double worstMs = 0;
+        for (size_t i = 0; i < 2 * target; ++i) {
+            auto t0 = std::chrono::steady_clock::now();
+            KeyPairPool::KeyPair kp = pool.take();
+            worstMs = std::max(worstMs, std::chrono::duration<double, std::milli>(
+                                            std::chrono::steady_clock::now() - t0).count());
+            if (kp.privateKeyPem.empty()) return -1;
+        }
+        s = pool.stats();
+        std::cout << "burst of " << 2 * target << " takes: " << s.misses << " generated inline, worst take "
+                  << worstMs << " ms, depth now " << s.depth << "\n";
+    }
+
+    {
+        KeyPairPool reloaded(&CryptoHandler::generateKeyPair, 0, path, storageKey);
+        std::cout << "reloaded from encrypted file: " << reloaded.stats().depth << " keys\n";
+    }
+    std::remove(path);
+    return 0;
+}
+
+// --- Payload encryption: RSA-OAEP against the X25519 hybrid, per receiver-side decrypt ---
+int runHybridBenchmark() {
+    const int rounds = 500;
+    const std::string payload = "sender@fastpay|100.00|" + DigitalSignature::getTimestampNonceString();
+    std::string rsaPub;
+    SecureString rsaPriv, hybridPriv;
+    std::vector<unsigned char> hybridPub;
+    CryptoHandler::generateKeyPair(rsaPub, rsaPriv);
+    CryptoHandler::generateHybridKeyPair(hybridPub, hybridPriv);
+
+    std::vector<unsigned char> rsaCt = CryptoHandler::encrypt(payload, rsaPub);
+    std::vector<unsigned char> hybridCt = CryptoHandler::hybridEncrypt(payload, hybridPub);
+    auto usPerOp = [rounds](auto&& op) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < rounds; ++i) op();
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / rounds;
+    };
+    bool ok = true;
+    double rsaEnc = usPerOp([&] { ok &= !CryptoHandler::encrypt(payload, rsaPub).empty(); });
+    double rsaDec = usPerOp([&] { ok &= CryptoHandler::decrypt(rsaCt, rsaPriv) == payload; });
+    double hybridEnc = usPerOp([&] { ok &= !CryptoHandler::hybridEncrypt(payload, hybridPub).empty(); });
+    double hybridDec = usPerOp([&] { ok &= CryptoHandler::hybridDecrypt(hybridCt, hybridPriv) == payload; });
+
+    std::cout << "Payload encryption, " << payload.size() << "-byte payload:\n"
+              << "  RSA-2048 OAEP: public key " << rsaPub.size() << " bytes, ciphertext " << rsaCt.size()
+              << " bytes, encrypt " << rsaEnc << " us, decrypt " << rsaDec << " us\n"
+              << "  X25519 hybrid: public key " << hybridPub.size() << " bytes, ciphertext " << hybridCt.size()
+              << " bytes, encrypt " << hybridEnc << " us, decrypt " << hybridDec << " us\n";
+
+    std::string large(64 * 1024, 'x');
+    ok &= CryptoHandler::hybridDecrypt(CryptoHandler::hybridEncrypt(large, hybridPub), hybridPriv) == large;
+    std::cout << "  64 KiB payload round trip: " << (ok ? "ok" : "FAILED") << "\n";
+    return ok ? 0 : -1;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::strcmp(argv[1], "bench-kdf") == 0)
+        return runPinKdfBenchmark();
+    if (argc > 1 && std::strcmp(argv[1], "bench-verify") == 0)
+        return runVerifyBenchmark();
+    if (argc > 1 && std::strcmp(argv[1], "bench-schemes") == 0)
+        return runSchemeBenchmark();
+    if (argc > 1 && std::strcmp(argv[1], "bench-keypool") == 0)
+        return runKeyPoolBenchmark();
+    if (argc > 1 && std::strcmp(argv[1], "bench-hybrid") == 0)
+        return runHybridBenchmark();
+
     std::cout << "=== Online (receiver emits ultrasound key; sender pays with PIN) ===\n";
     runOnlineFlow();
     std::cout << "\n=== Offline (cold wallet: sign -> verify -> receipt) ===\n";
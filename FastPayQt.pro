@@ -1,9 +1,9 @@
 # FastPay — Qt for Android (and desktop)
-QT       += core gui widgets network multimedia
+QT       += core gui widgets network multimedia concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
-CONFIG += c++17
+CONFIG += c++20
 
 # OpenSSL linking
 unix:!android {
@@ -33,24 +33,66 @@ SOURCES += \
     mainwindow.cpp \
     transactionengine.cpp \
     ultrasoundhelper.cpp \
+    ultrasoundemitter.cpp \
+    ultrasoundreceiver.cpp \
     transactionhistory.cpp \
+    recordjournal.cpp \
+    historytablemodel.cpp \
+    historystore.cpp \
+    money.cpp \
+    offlineoutbox.cpp \
+    serverconnection.cpp \
     pindialog.cpp \
+    authstate.cpp \
     Crypto/AES.cpp \
     Crypto/ECDSA.cpp \
     Crypto/RSA.cpp \
     Crypto/Ultrasound.cpp \
+    Crypto/PinKdf.cpp \
+    Crypto/KeyCache.cpp \
+    Crypto/Ed25519.cpp \
+    Crypto/AeadStream.cpp \
+    Crypto/KeyPairPool.cpp \
+    Crypto/Hybrid.cpp \
+    Crypto/SecureArena.cpp \
+    Crypto/PhoneHash.cpp \
+    Crypto/Fec.cpp \
+    Crypto/Fft.cpp \
+    Crypto/FskModem.cpp \
     Crypto/transaction.cpp
 
 HEADERS += \
     mainwindow.h \
     transactionengine.h \
     ultrasoundhelper.h \
+    ultrasoundemitter.h \
+    ultrasoundreceiver.h \
     transactionhistory.h \
+    recordjournal.h \
+    historytablemodel.h \
+    historystore.h \
+    transactionrecord.h \
+    money.h \
+    offlineoutbox.h \
+    serverconnection.h \
     pindialog.h \
+    authstate.h \
     server_config.h \
     Crypto/AES.h \
+    Crypto/Bytes.h \
+    Crypto/AeadStream.h \
     Crypto/CryptoHandler.h \
     Crypto/DigitalSignature.h \
+    Crypto/Fec.h \
+    Crypto/Fft.h \
+    Crypto/FskModem.h \
+    Crypto/KeyCache.h \
+    Crypto/KeyPairPool.h \
+    Crypto/SignatureScheme.h \
+    Crypto/PhoneHash.h \
+    Crypto/PinKdf.h \
+    Crypto/SecureArena.h \
+    Crypto/SpscRing.h \
     Crypto/Ultrasound.h
 
 INCLUDEPATH += $$PWD/Crypto
@@ -0,0 +1,157 @@
+#include "authstate.h"
+#include <QCryptographicHash>
+#include <QSaveFile>
+#include <QSettings>
+#include <QDebug>
+#include <openssl/crypto.h>
+#include <cctype>
+#include <cstring>
+
+static const char kKdfName[] = "pbkdf2-sha256";
+
+AuthState::AuthState(const QString &path)
+    : m_path(path)
+    , m_secret(new (SecureArena::instance().allocate(sizeof(Secret))) Secret{})
+{
+    if (!SecureArena::instance().stats().locked)
+        qWarning() << "AuthState: could not lock PIN verifier in memory";
+    load();
+}
+
+AuthState::~AuthState()
+{
+    SecureArena::instance().deallocate(m_secret, sizeof(Secret));     // wipes it
+}
+
+void AuthState::load()
+{
+    QSettings s(m_path, QSettings::IniFormat);
+    const QByteArray hash = QByteArray::fromHex(s.value(QStringLiteral("pin_hash")).toByteArray());
+    if (hash.size() != int(PinKdf::HASH_SIZE)) return;
+
+    const QString kdf = s.value(QStringLiteral("pin_kdf")).toString();
+    if (kdf.isEmpty()) {
+        m_legacy = true;
+    } else if (kdf == QLatin1String(kKdfName)) {
+        const QByteArray salt = QByteArray::fromHex(s.value(QStringLiteral("pin_salt")).toByteArray());
+        m_iterations = s.value(QStringLiteral("pin_iterations")).toUInt();
+        if (salt.size() != int(PinKdf::SALT_SIZE) || m_iterations == 0) return;
+        std::memcpy(m_secret->salt, salt.constData(), PinKdf::SALT_SIZE);
+    } else {
+        qWarning() << "AuthState: unknown PIN KDF" << kdf;
+        return;
+    }
+    std::memcpy(m_secret->hash, hash.constData(), PinKdf::HASH_SIZE);
+    m_hasPin = true;
+}
+
+// Rewrites auth.ini in the QSettings INI layout via a temp file + rename
+bool AuthState::save(const Secret &secret, quint32 iterations)
+{
+    QSaveFile f(m_path);
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Text)) return false;
+    f.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner);
+    const QByteArray salt = QByteArray::fromRawData(reinterpret_cast<const char *>(secret.salt), sizeof(secret.salt));
+    const QByteArray hash = QByteArray::fromRawData(reinterpret_cast<const char *>(secret.hash), sizeof(secret.hash));
+    f.write("[General]\n");
+    f.write("pin_kdf=" + QByteArray(kKdfName) + "\n");
+    f.write("pin_iterations=" + QByteArray::number(iterations) + "\n");
+    f.write("pin_salt=" + salt.toHex() + "\n");
+    f.write("pin_hash=" + hash.toHex() + "\n");
+    return f.commit();
+}
+
+bool AuthState::hasPin() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_hasPin;
+}
+
+quint32 AuthState::iterations() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_iterations;
+}
+
+// The PIN without surrounding whitespace, as a view into the caller's (wiped) buffer
+static std::string_view trimmedPin(const SecureString &pin)
+{
+    std::string_view p(pin);
+    while (!p.empty() && std::isspace(static_cast<unsigned char>(p.front()))) p.remove_prefix(1);
+    while (!p.empty() && std::isspace(static_cast<unsigned char>(p.back()))) p.remove_suffix(1);
+    return p;
+}
+
+bool AuthState::setPin(const SecureString &pin)
+{
+    return setPinIfUnchanged(trimmedPin(pin), nullptr);
+}
+
+bool AuthState::setPinIfUnchanged(std::string_view p, const unsigned char *expectedHash)
+{
+    if (p.size() < 4 || p.size() > 6) return false;
+
+    // Derive outside the lock: this is the deliberately slow part
+    Secret fresh;
+    const quint32 iterations = PinKdf::calibrate(kTargetVerifyMs);
+    bool ok = PinKdf::randomSalt(fresh.salt, sizeof(fresh.salt))
+              && PinKdf::derive(p.data(), p.size(), fresh.salt, sizeof(fresh.salt),
+                                iterations, fresh.hash, sizeof(fresh.hash));
+    if (ok) {
+        QMutexLocker lock(&m_mutex);
+        if (expectedHash && (!m_legacy || !PinKdf::equals(expectedHash, m_secret->hash, PinKdf::HASH_SIZE))) {
+            OPENSSL_cleanse(&fresh, sizeof(fresh));
+            return true;
+        }
+        ok = save(fresh, iterations);
+        if (ok) {
+            std::memcpy(m_secret, &fresh, sizeof(Secret));
+            m_iterations = iterations;
+            m_hasPin = true;
+            m_legacy = false;
+        }
+    }
+    OPENSSL_cleanse(&fresh, sizeof(fresh));
+    return ok;
+}
+
+bool AuthState::verify(const SecureString &pin)
+{
+    const std::string_view p = trimmedPin(pin);
+    if (p.empty()) return false;
+
+    unsigned char salt[PinKdf::SALT_SIZE];
+    quint32 iterations = 0;
+    bool legacy = false;
+    {
+        QMutexLocker lock(&m_mutex);
+        if (!m_hasPin) return false;
+        std::memcpy(salt, m_secret->salt, sizeof(salt));
+        iterations = m_iterations;
+        legacy = m_legacy;
+    }
+
+    unsigned char candidate[PinKdf::HASH_SIZE];
+    bool derived;
+    if (legacy) {
+        const QByteArray digest = QCryptographicHash::hash(QByteArrayView(p.data(), qsizetype(p.size())),
+                                                          QCryptographicHash::Sha256);
+        std::memcpy(candidate, digest.constData(), sizeof(candidate));
+        derived = true;
+    } else {
+        derived = PinKdf::derive(p.data(), p.size(), salt, sizeof(salt),
+                                 iterations, candidate, sizeof(candidate));
+    }
+
+    bool ok = false;
+    if (derived) {
+        QMutexLocker lock(&m_mutex);
+        ok = PinKdf::equals(candidate, m_secret->hash, sizeof(candidate));
+    }
+
+    // The lock was dropped above: a setPin in between must not be overwritten with this PIN
+    if (ok && legacy && !setPinIfUnchanged(p, candidate))
+        qWarning() << "AuthState: could not upgrade legacy PIN hash";
+    OPENSSL_cleanse(candidate, sizeof(candidate));
+    return ok;
+}
@@ -0,0 +1,48 @@
+#ifndef AUTHSTATE_H
+#define AUTHSTATE_H
+
+#include <QMutex>
+#include <QString>
+#include "PinKdf.h"
+#include "SecureArena.h"
+
+// UPI PIN verifier, read from auth.ini once and kept in memory locked against swapping.
+// The PIN is stretched with salted PBKDF2 at a cost calibrated when it is set, compared in
+// constant time, and written back atomically (QSaveFile). Safe to use from worker threads.
+class AuthState
+{
+public:
+    explicit AuthState(const QString &path);
+    ~AuthState();
+    AuthState(const AuthState &) = delete;
+    AuthState &operator=(const AuthState &) = delete;
+
+    bool hasPin() const;
+    bool setPin(const SecureString &pin);
+    // A legacy (bare SHA-256) entry is rehashed with the KDF on the first successful verify
+    bool verify(const SecureString &pin);
+    quint32 iterations() const;
+
+    static constexpr double kTargetVerifyMs = 250.0;
+
+private:
+    struct Secret {
+        unsigned char salt[PinKdf::SALT_SIZE];
+        unsigned char hash[PinKdf::HASH_SIZE];
+    };
+
+    void load();
+    bool save(const Secret &secret, quint32 iterations);
+    // setPin, but only while the entry is still the legacy one hashing to expectedHash; a PIN
+    // changed meanwhile is left alone (and counts as success)
+    bool setPinIfUnchanged(std::string_view pin, const unsigned char *expectedHash);
+
+    QString m_path;
+    mutable QMutex m_mutex;
+    Secret *m_secret = nullptr;     // in SecureArena: page-locked, wiped on destruction
+    quint32 m_iterations = 0;
+    bool m_hasPin = false;
+    bool m_legacy = false;
+};
+
+#endif // AUTHSTATE_H
@@ -0,0 +1,231 @@
+#include "historystore.h"
+#include <QDebug>
+#include <QTimeZone>
+#include <limits>
+
+static constexpr qint64 kNoTimestamp = std::numeric_limits<qint64>::min();
+static const QString kNonceFormat = QStringLiteral("yyyy-MM-dd HH:mm:ss");
+static const QString kNonceDateFormat = QStringLiteral("yyyy-MM-dd");
+static const QString kNonceTimeFormat = QStringLiteral("HH:mm:ss");
+
+static HistoryStore::Type typeFromString(const QString &s)
+{
+    if (s == QLatin1String("online")) return HistoryStore::Type::Online;
+    if (s == QLatin1String("offline")) return HistoryStore::Type::Offline;
+    return HistoryStore::Type::Unknown;
+}
+
+static HistoryStore::Role roleFromString(const QString &s)
+{
+    if (s == QLatin1String("sender")) return HistoryStore::Role::Sender;
+    if (s == QLatin1String("receiver")) return HistoryStore::Role::Receiver;
+    return HistoryStore::Role::Unknown;
+}
+
+static HistoryStore::Status statusFromString(const QString &s)
+{
+    if (s == QLatin1String("pending")) return HistoryStore::Status::Pending;
+    if (s == QLatin1String("completed")) return HistoryStore::Status::Completed;
+    if (s == QLatin1String("failed")) return HistoryStore::Status::Failed;
+    if (s == QLatin1String("frozen")) return HistoryStore::Status::Frozen;
+    return HistoryStore::Status::Unknown;
+}
+
+quint32 HistoryStore::internPeer(const QString &peerId)
+{
+    auto it = m_peerIndex.constFind(peerId);
+    if (it != m_peerIndex.constEnd()) return it.value();
+    const quint32 index = quint32(m_peers.size());
+    m_peers.append(peerId);
+    m_peerIndex.insert(peerId, index);
+    return index;
+}
+
+quint8 HistoryStore::internCurrency(quint32 currencyTag)
+{
+    // 0 is reserved for "invalid", so index i is stored as i + 1
+    if (currencyTag == 0) return 0;
+    int index = m_currencies.indexOf(currencyTag);
+    if (index < 0) {
+        // A handful of currencies at most; fall back to "invalid" past 255
+        if (m_currencies.size() >= std::numeric_limits<quint8>::max()) {
+            qWarning() << "History holds too many currencies; storing an invalid amount";
+            return 0;
+        }
+        index = int(m_currencies.size());
+        m_currencies.append(currencyTag);
+    }
+    return quint8(index + 1);
+}
+
+Money HistoryStore::amount(int row) const
+{
+    const Row &r = m_rows[row];
+    if (r.currency == 0) return Money();
+    return Money::fromMinorUnits(r.amountMinor, m_currencies.at(r.currency - 1));
+}
+
+void HistoryStore::append(const TransactionRecord &record)
+{
+    const int rowIndex = int(m_rows.size());
+    Row row;
+    row.createdAtMs = record.createdAt.isValid() ? record.createdAt.toMSecsSinceEpoch() : kNoTimestamp;
+    row.flags = 0;
+
+    row.amountMinor = record.amount.minorUnits();
+    row.currency = internCurrency(record.amount.currencyTag());
+    if (!record.amount.isValid() && !record.amountText.isEmpty()) {
+        row.flags |= RawAmount;
+        m_rawAmounts.insert(rowIndex, record.amountText);
+    }
+
+    // The nonce is wall-clock text without a zone. It is read as UTC, which maps every
+    // date and time one-to-one, so nonce() gives back the same text in any time zone.
+    const QDateTime nonceTime(QDate::fromString(record.nonce.left(10), kNonceDateFormat),
+                              QTime::fromString(record.nonce.mid(11), kNonceTimeFormat), QTimeZone::UTC);
+    if (nonceTime.isValid() && nonceTime.toString(kNonceFormat) == record.nonce) {
+        row.nonceSecs = nonceTime.toSecsSinceEpoch();
+    } else {
+        row.nonceSecs = kNoTimestamp;
+        row.flags |= RawNonce;
+        m_rawNonces.insert(rowIndex, record.nonce);
+    }
+
+    const QByteArray id = record.id.toUtf8();
+    row.idOffset = quint32(m_idArena.size());
+    if (id.size() > std::numeric_limits<quint16>::max()) {
+        qWarning() << "History id of" << id.size() << "bytes kept outside the id arena";
+        row.idLength = 0;
+        row.flags |= LongId;
+        m_longIds.insert(rowIndex, record.id);
+    } else {
+        row.idLength = quint16(id.size());
+        m_idArena.append(id);
+    }
+
+    row.peer = internPeer(record.peerId);
+    row.type = typeFromString(record.type);
+    row.role = roleFromString(record.role);
+    row.status = statusFromString(record.status);
+    // Text the enums don't know (a newer or hand-edited record) is kept as it was
+    if (row.type == Type::Unknown && !record.type.isEmpty()) {
+        row.flags |= RawType;
+        m_rawText[rowIndex].type = record.type;
+    }
+    if (row.role == Role::Unknown && !record.role.isEmpty()) {
+        row.flags |= RawRole;
+        m_rawText[rowIndex].role = record.role;
+    }
+    if (row.status == Status::Unknown && !record.status.isEmpty()) {
+        row.flags |= RawStatus;
+        m_rawText[rowIndex].status = record.status;
+    }
+    m_rows.append(row);
+}
+
+void HistoryStore::append(const QList<TransactionRecord> &records)
+{
+    m_rows.reserve(m_rows.size() + records.size());
+    for (const TransactionRecord &r : records)
+        append(r);
+}
+
+void HistoryStore::clear()
+{
+    m_rows.clear();
+    m_idArena.clear();
+    m_peers.clear();
+    m_peerIndex.clear();
+    m_currencies.clear();
+    m_rawNonces.clear();
+    m_rawAmounts.clear();
+    m_rawText.clear();
+    m_longIds.clear();
+}
+
+TransactionRecord HistoryStore::at(int row) const
+{
+    TransactionRecord r;
+    r.id = id(row);
+    r.type = typeName(row);
+    r.role = roleName(row);
+    r.peerId = peerId(row);
+    r.amount = amount(row);
+    if (m_rows[row].flags & RawAmount)
+        r.amountText = m_rawAmounts.value(row);
+    r.nonce = nonce(row);
+    r.status = statusName(row);
+    const qint64 created = m_rows[row].createdAtMs;
+    r.createdAt = created == kNoTimestamp ? QDateTime() : QDateTime::fromMSecsSinceEpoch(created);
+    return r;
+}
+
+QList<TransactionRecord> HistoryStore::toList() const
+{
+    QList<TransactionRecord> list;
+    list.reserve(m_rows.size());
+    for (int i = 0; i < size(); ++i)
+        list.append(at(i));
+    return list;
+}
+
+QString HistoryStore::id(int row) const
+{
+    const Row &r = m_rows[row];
+    if (r.flags & LongId) return m_longIds.value(row);
+    return QString::fromUtf8(m_idArena.constData() + r.idOffset, r.idLength);
+}
+
+QString HistoryStore::typeName(int row) const
+{
+    switch (m_rows[row].type) {
+    case Type::Online:  return QStringLiteral("online");
+    case Type::Offline: return QStringLiteral("offline");
+    default:
+        return (m_rows[row].flags & RawType) ? m_rawText.value(row).type : QString();
+    }
+}
+
+QString HistoryStore::roleName(int row) const
+{
+    switch (m_rows[row].role) {
+    case Role::Sender:   return QStringLiteral("sender");
+    case Role::Receiver: return QStringLiteral("receiver");
+    default:
+        return (m_rows[row].flags & RawRole) ? m_rawText.value(row).role : QString();
+    }
+}
+
+QString HistoryStore::statusName(int row) const
+{
+    switch (m_rows[row].status) {
+    case Status::Pending:   return QStringLiteral("pending");
+    case Status::Completed: return QStringLiteral("completed");
+    case Status::Failed:    return QStringLiteral("failed");
+    case Status::Frozen:    return QStringLiteral("frozen");
+    default:
+        return (m_rows[row].flags & RawStatus) ? m_rawText.value(row).status : QString();
+    }
+}
+
+QString HistoryStore::amountText(int row) const
+{
+    if (m_rows[row].flags & RawAmount) return m_rawAmounts.value(row);
+    return amount(row).toString();
+}
+
+QString HistoryStore::nonce(int row) const
+{
+    if (m_rows[row].flags & RawNonce) return m_rawNonces.value(row);
+    return QDateTime::fromSecsSinceEpoch(m_rows[row].nonceSecs, QTimeZone::UTC).toString(kNonceFormat);
+}
+
+qsizetype HistoryStore::memoryUsage() const
+{
+    qsizetype bytes = m_rows.capacity() * qsizetype(sizeof(Row)) + m_idArena.capacity()
+                      + m_currencies.capacity() * qsizetype(sizeof(quint32));
+    for (const QString &p : m_peers)
+        bytes += p.capacity() * qsizetype(sizeof(QChar));
+    bytes += m_peerIndex.size() * qsizetype(sizeof(QString) + sizeof(quint32));
+    return bytes;
+}
@@ -0,0 +1,94 @@
+#ifndef HISTORYSTORE_H
+#define HISTORYSTORE_H
+
+#include "transactionrecord.h"
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QStringList>
+#include <QVector>
+
+// Compact in-memory history: one fixed-size row per record, enums for the small
+// vocabularies, interned peer IDs and integer amounts/timestamps. TransactionRecord
+// is materialized on demand by at(); hot paths use the column accessors instead.
+class HistoryStore
+{
+public:
+    enum class Type : quint8 { Unknown, Online, Offline };
+    enum class Role : quint8 { Unknown, Sender, Receiver };
+    enum class Status : quint8 { Unknown, Pending, Completed, Failed, Frozen };
+
+    void append(const TransactionRecord &record);
+    void append(const QList<TransactionRecord> &records);
+    void clear();
+
+    int size() const { return int(m_rows.size()); }
+    bool isEmpty() const { return m_rows.isEmpty(); }
+    TransactionRecord at(int row) const;
+    QList<TransactionRecord> toList() const;
+
+    // Column accessors (no TransactionRecord materialization)
+    QString id(int row) const;
+    Type type(int row) const { return m_rows[row].type; }
+    Role role(int row) const { return m_rows[row].role; }
+    Status status(int row) const { return m_rows[row].status; }
+    QString typeName(int row) const;
+    QString roleName(int row) const;
+    QString statusName(int row) const;
+    QString peerId(int row) const { return m_peers.at(m_rows[row].peer); }
+    qint64 amountMinor(int row) const { return m_rows[row].amountMinor; }
+    Money amount(int row) const;
+    // Canonical amount, or the original text of one that did not parse
+    QString amountText(int row) const;
+    QString nonce(int row) const;
+    qint64 createdAtMSecs(int row) const { return m_rows[row].createdAtMs; }
+
+    // Approximate heap footprint, for tuning
+    qsizetype memoryUsage() const;
+
+private:
+    enum Flag : quint8 {
+        RawNonce = 0x01,    // nonce text did not round-trip through epoch seconds
+        RawAmount = 0x02,   // legacy amount text did not parse as Money
+        RawType = 0x04,     // type/role/status text the enums don't know
+        RawRole = 0x08,
+        RawStatus = 0x10,
+        LongId = 0x20,      // id too long for idLength; kept whole in m_longIds
+    };
+
+    struct Row {
+        qint64 createdAtMs;
+        qint64 nonceSecs;
+        qint64 amountMinor;
+        quint32 idOffset;   // into m_idArena (UTF-8)
+        quint32 peer;       // index into m_peers
+        quint16 idLength;
+        Type type;
+        Role role;
+        Status status;
+        quint8 flags;
+        quint8 currency;    // index into m_currencies plus one; 0 = invalid
+    };
+
+    quint32 internPeer(const QString &peerId);
+    quint8 internCurrency(quint32 currencyTag);
+
+    QVector<Row> m_rows;
+    QByteArray m_idArena;
+    QStringList m_peers;
+    QHash<QString, quint32> m_peerIndex;
+    QVector<quint32> m_currencies;
+    // Rare rows whose nonce is not in canonical form keep the original text here
+    QHash<int, QString> m_rawNonces;
+    // ... and likewise legacy amounts Money could not parse (e.g. "50.123")
+    QHash<int, QString> m_rawAmounts;
+    struct RawText {
+        QString type;
+        QString role;
+        QString status;
+    };
+    QHash<int, RawText> m_rawText;
+    QHash<int, QString> m_longIds;
+};
+
+#endif // HISTORYSTORE_H
@@ -0,0 +1,84 @@
+#include "historytablemodel.h"
+
+HistoryTableModel::HistoryTableModel(TransactionEngine *engine, QObject *parent)
+    : QAbstractTableModel(parent)
+    , m_engine(engine)
+{
+    connect(m_engine, &TransactionEngine::historyUpdated, this, &HistoryTableModel::onHistoryUpdated);
+}
+
+int HistoryTableModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_loadedRows;
+}
+
+int HistoryTableModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant HistoryTableModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_loadedRows) return QVariant();
+    if (role != Qt::DisplayRole && role != Qt::ToolTipRole) return QVariant();
+
+    const HistoryStore &h = m_engine->localHistory();
+    const int row = index.row();
+    switch (index.column()) {
+    case IdColumn:     return role == Qt::ToolTipRole ? h.id(row) : h.id(row).left(8);
+    case TypeColumn:   return h.typeName(row);
+    case RoleColumn:   return h.roleName(row);
+    case PeerColumn:   return h.peerId(row);
+    case AmountColumn: return h.amountText(row);
+    case NonceColumn:  return h.nonce(row);
+    case StatusColumn: return h.statusName(row);
+    default:           return QVariant();
+    }
+}
+
+QVariant HistoryTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+        return QAbstractTableModel::headerData(section, orientation, role);
+    switch (section) {
+    case IdColumn:     return tr("ID");
+    case TypeColumn:   return tr("Type");
+    case RoleColumn:   return tr("Role");
+    case PeerColumn:   return tr("Peer");
+    case AmountColumn: return tr("Amount");
+    case NonceColumn:  return tr("Nonce");
+    case StatusColumn: return tr("Status");
+    default:           return QVariant();
+    }
+}
+
+bool HistoryTableModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && m_loadedRows < m_engine->localHistory().size();
+}
+
+void HistoryTableModel::fetchMore(const QModelIndex &parent)
+{
+    if (parent.isValid()) return;
+    int remaining = m_engine->localHistory().size() - m_loadedRows;
+    int count = qMin(m_pageSize, remaining);
+    if (count <= 0) return;
+    beginInsertRows(QModelIndex(), m_loadedRows, m_loadedRows + count - 1);
+    m_loadedRows += count;
+    endInsertRows();
+}
+
+void HistoryTableModel::onHistoryUpdated(const QList<TransactionRecord> &added)
+{
+    const int total = m_engine->localHistory().size();
+    if (total < m_loadedRows) {
+        // History was reloaded from scratch
+        beginResetModel();
+        m_loadedRows = 0;
+        endResetModel();
+        return;
+    }
+    // Only surface new rows right away if the user has already paged to the end
+    if (m_loadedRows == total - int(added.size()))
+        fetchMore(QModelIndex());
+}
@@ -0,0 +1,36 @@
+#ifndef HISTORYTABLEMODEL_H
+#define HISTORYTABLEMODEL_H
+
+#include <QAbstractTableModel>
+#include "transactionengine.h"
+
+// Read-only table over the engine's resident history. Rows are exposed a page at a
+// time through canFetchMore()/fetchMore(), so the view only ever touches what it shows.
+class HistoryTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    enum Column { IdColumn, TypeColumn, RoleColumn, PeerColumn, AmountColumn, NonceColumn, StatusColumn, ColumnCount };
+
+    explicit HistoryTableModel(TransactionEngine *engine, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+    void setPageSize(int rows) { m_pageSize = qMax(1, rows); }
+
+private slots:
+    void onHistoryUpdated(const QList<TransactionRecord> &added);
+
+private:
+    TransactionEngine *m_engine = nullptr;
+    int m_loadedRows = 0;
+    int m_pageSize = 128;
+};
+
+#endif // HISTORYTABLEMODEL_H
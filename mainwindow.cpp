@@ -1,12 +1,13 @@
 #include "mainwindow.h"
 #include "transactionengine.h"
 #include "ultrasoundhelper.h"
-#include "transactionhistory.h"
+#include "historytablemodel.h"
 #include "pindialog.h"
 #include "server_config.h"
 #include <QMessageBox>
 #include <QDateTime>
-#include <QTableWidget>
+#include <QTableView>
+#include <QHeaderView>
 #include <QDialog>
 #include <QGroupBox>
 #include <QPushButton>
@@ -19,6 +20,10 @@
 #include <QScrollArea>
 #include <QFrame>
 #include <QPixmap>
+#include <QSettings>
+
+// Opens every online frame; the listener ignores frames that don't carry it
+static const char ONLINE_FRAME_HEADER[] = "FASTPAY_ONLINE_V1";
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -77,8 +82,8 @@ void MainWindow::applyStyleSheet()
         QTabBar::tab:selected { background: #161b22; color: #58a6ff; }
         QTabBar::tab:hover:!selected { background: #30363d; }
         QScrollArea { border: none; background: transparent; }
-        QTableWidget { background: #21262d; color: #e6edf3; gridline-color: #30363d; border-radius: 8px; }
-        QTableWidget::item { padding: 4px; }
+        QTableView { background: #21262d; color: #e6edf3; gridline-color: #30363d; border-radius: 8px; }
+        QTableView::item { padding: 4px; }
         QHeaderView::section { background: #161b22; color: #58a6ff; padding: 8px; }
         QDialog { background: #161b22; }
     )");
@@ -87,9 +92,12 @@ void MainWindow::applyStyleSheet()
 void MainWindow::ensurePinSet()
 {
     if (!m_engine->hasPinSet()) {
-        QString pin;
-        if (PinDialog::askSetPin(this, pin))
-            m_engine->setPin(pin);
+        SecureString pin;
+        if (PinDialog::askSetPin(this, pin)) {
+            m_engine->setPinAsync(pin).then(this, [this](bool ok) {
+                if (!ok) QMessageBox::warning(this, tr("UPI PIN"), tr("Could not save the UPI PIN."));
+            });
+        }
     }
 }
 
@@ -130,6 +138,15 @@ void MainWindow::setupUi()
     pubKeyLabel->setWordWrap(true);
     pubKeyLabel->setStyleSheet("color: #8b949e; font-size: 11px;");
     identityForm->addRow(tr("Public key (hash):"), pubKeyLabel);
+    // The signed-in account: reported as the local party when offline transfers sync
+    QLineEdit *leUserId = new QLineEdit(this);
+    leUserId->setPlaceholderText(tr("e.g. name@fastpay (defaults to phone number)"));
+    leUserId->setObjectName("localUserId");
+    leUserId->setText(QSettings().value(QStringLiteral("account/userId")).toString());
+    connect(leUserId, &QLineEdit::editingFinished, this, [leUserId]() {
+        QSettings().setValue(QStringLiteral("account/userId"), leUserId->text().trimmed());
+    });
+    identityForm->addRow(tr("Your UPI ID:"), leUserId);
     QLineEdit *leServerUrl = new QLineEdit(this);
     leServerUrl->setPlaceholderText(tr("e.g. http://localhost:8000 (optional)"));
     leServerUrl->setObjectName("serverBaseUrl");
@@ -284,18 +301,18 @@ void MainWindow::onOnlineReceiveEmit()
     QString phone = lePhone ? lePhone->text().trimmed() : QString();
     QByteArray pubKey = TransactionEngine::publicKeyFromPhoneNumber(phone);
     if (pubKey.isEmpty()) pubKey = QByteArray("FASTPAY_DEMO_KEY");
-    QByteArray header("FASTPAY_ONLINE_V1");
+    QByteArray header(ONLINE_FRAME_HEADER);
     QByteArray payload = m_engine->buildOnlineEmitPayload(header, pubKey);
     m_ultrasound->startEmitting(payload);
-    QMessageBox::information(this, tr("Online receive"), tr("Emitting ultrasound (header + public key). Sender captures 2x and extracts key."));
+    QMessageBox::information(this, tr("Online receive"), tr("Emitting ultrasound (header + public key). The sender's phone decodes it from the mic."));
 }
 
 void MainWindow::onOnlineSendCapture()
 {
-    m_ultrasound->startListening();
+    m_ultrasound->startListening(QByteArray(ONLINE_FRAME_HEADER));
     QLabel *nonceL = findChild<QLabel*>("onlineNonceLabel");
     if (nonceL) nonceL->setText(currentNonce());
-    QMessageBox::information(this, tr("Online send"), tr("Listening on mic (buffer 2x). When header is found, key will be extracted."));
+    QMessageBox::information(this, tr("Online send"), tr("Listening on mic. The key is extracted as soon as the receiver's frame decodes."));
 }
 
 void MainWindow::onKeyReceivedFromMic(const QByteArray &key)
@@ -307,27 +324,27 @@ void MainWindow::onKeyReceivedFromMic(const QByteArray &key)
 void MainWindow::onOnlineSendSubmit()
 {
     QLineEdit *amountEdit = findChild<QLineEdit*>("onlineAmount");
-    QString amount = amountEdit ? amountEdit->text().trimmed() : QString();
-    if (amount.isEmpty()) {
+    QString amountText = amountEdit ? amountEdit->text().trimmed() : QString();
+    if (amountText.isEmpty()) {
         QMessageBox::warning(this, tr("Amount required"), tr("Enter amount."));
         return;
     }
-    QString pin = PinDialog::askPin(this, tr("Enter UPI PIN to approve"));
-    if (pin.isEmpty()) return;
+    Money amount = Money::fromString(amountText);
+    if (!amount.isValid() || amount.minorUnits() <= 0) {
+        QMessageBox::warning(this, tr("Invalid amount"), tr("Enter a positive amount with at most two decimals."));
+        return;
+    }
+    const SecureString pin = PinDialog::askPin(this, tr("Enter UPI PIN to approve"));
+    if (pin.empty()) return;
+    // Both paths finish asynchronously; see onOnlineTransactionCompleted / onOnlineTransactionFailed
     QLineEdit *serverUrlEdit = findChild<QLineEdit*>("serverBaseUrl");
     QString serverUrl = serverUrlEdit ? serverUrlEdit->text().trimmed() : QString();
     if (!serverUrl.isEmpty()) {
         m_engine->setServerBaseUrl(serverUrl);
         m_engine->submitOnlineTransactionToServer("sender@fastpay", "receiver@fastpay", amount, pin);
-        // Success/failure and amount clear handled by onOnlineTransactionCompleted / onOnlineTransactionFailed
     } else {
         QByteArray receiverKey("DEMO_KEY");
-        bool ok = m_engine->submitOnlineTransaction("sender@fastpay", amount, receiverKey, pin);
-        if (ok) {
-            QMessageBox::information(this, tr("Online"), tr("Transaction initiated. Receiver gets notification. Nonce: %1").arg(currentNonce()));
-            if (amountEdit) amountEdit->clear();
-        } else
-            QMessageBox::warning(this, tr("Error"), tr("Transaction failed. Check your UPI PIN."));
+        m_engine->submitOnlineTransaction("sender@fastpay", amount, receiverKey, pin);
     }
 }
 
@@ -355,40 +372,77 @@ void MainWindow::onOfflineSendSign()
         QMessageBox::warning(this, tr("Offline send"), tr("Fill sender, receiver, amount."));
         return;
     }
-    QString pin = PinDialog::askPin(this, tr("Enter UPI PIN to approve signing"));
-    if (pin.isEmpty()) return;
-    if (!m_engine->verifyPin(pin)) {
-        QMessageBox::warning(this, tr("Wrong PIN"), tr("UPI PIN incorrect. Transaction not approved."));
+    Money money = Money::fromString(a);
+    if (!money.isValid() || money.minorUnits() <= 0) {
+        QMessageBox::warning(this, tr("Offline send"), tr("Enter a positive amount with at most two decimals."));
         return;
     }
-    QString nonce = currentNonce();
-    QByteArray sig = m_engine->signOfflineTransaction(s, r, a, nonce, QByteArray());
-    if (!sig.isEmpty())
-        QMessageBox::information(this, tr("Offline send"), tr("Transaction signed. Nonce: %1. Send to receiver for verification and receipt.").arg(nonce));
+    const SecureString pin = PinDialog::askPin(this, tr("Enter UPI PIN to approve signing"));
+    if (pin.empty()) return;
+    const QString nonce = currentNonce();
+    m_engine->verifyPinAsync(pin).then(this, [this, s, r, money, nonce](bool ok) {
+        if (!ok) {
+            QMessageBox::warning(this, tr("Wrong PIN"), tr("UPI PIN incorrect. Transaction not approved."));
+            return;
+        }
+        m_engine->signOfflineTransactionAsync(s, r, money, nonce, QByteArray()).then(this, [this, nonce](const QByteArray &sig) {
+            if (!sig.isEmpty())
+                QMessageBox::information(this, tr("Offline send"), tr("Transaction signed. Nonce: %1. Send to receiver for verification and receipt.").arg(nonce));
+        }).onCanceled(this, [this]() { showBusy(); });
+    }).onCanceled(this, [this]() { showBusy(); });
+}
+
+QString MainWindow::localUserId() const
+{
+    QLineEdit *userId = findChild<QLineEdit*>("localUserId");
+    QString id = userId ? userId->text().trimmed() : QString();
+    if (id.isEmpty()) {
+        QLineEdit *phone = findChild<QLineEdit*>("phoneNumber");
+        id = phone ? phone->text().trimmed() : QString();
+    }
+    return id;
 }
 
 void MainWindow::onOfflineReceiveVerify()
 {
-    QString message = "cold_sender@fastpay|cold_receiver@fastpay|50.00|" + currentNonce();
-    QByteArray signature = m_engine->signOfflineTransaction("cold_sender@fastpay", "cold_receiver@fastpay", "50.00", currentNonce(), QByteArray());
-    bool ok = m_engine->verifyOfflineTransaction(message, signature, QByteArray());
-    if (ok) {
-        m_engine->signReceipt(message, QByteArray());
-        TransactionRecord rec;
-        rec.id = QString::number(QDateTime::currentMSecsSinceEpoch());
-        rec.type = "offline";
-        rec.role = "receiver";
-        rec.peerId = "cold_sender@fastpay";
-        rec.amount = "50.00";
-        rec.nonce = currentNonce();
-        rec.status = "completed";
-        rec.createdAt = QDateTime::currentDateTime();
-        m_engine->submitOfflineWhenOnline(rec);
-        QMessageBox::information(this, tr("Offline receive"), tr("Verified. Receipt emitted. When both come online, transaction will be stored on server."));
-    } else {
-        m_engine->freezeAccountOnVerificationFailure();
-        QMessageBox::critical(this, tr("Verification failed"), tr("Transaction failed. Account frozen."));
+    const QString userId = localUserId();
+    if (userId.isEmpty()) {
+        QMessageBox::warning(this, tr("Offline receive"), tr("Enter your UPI ID or phone number first."));
+        return;
     }
+    const Money amount(5000);
+    const QString nonce = currentNonce();
+    const QString message = TransactionEngine::offlineMessage("cold_sender@fastpay", userId, amount, nonce);
+    m_engine->signOfflineTransactionAsync("cold_sender@fastpay", userId, amount, nonce, QByteArray())
+        .then(this, [this, message, amount, nonce, userId](const QByteArray &signature) {
+        m_engine->verifyOfflineTransactionAsync(message, signature, QByteArray())
+            .then(this, [this, message, amount, nonce, signature, userId](bool ok) {
+            if (!ok) {
+                m_engine->freezeAccountOnVerificationFailure();
+                QMessageBox::critical(this, tr("Verification failed"), tr("Transaction failed. Account frozen."));
+                return;
+            }
+            m_engine->signReceiptAsync(message, QByteArray())
+                .then(this, [this, amount, nonce, signature, userId](const QByteArray &receipt) {
+                TransactionRecord rec;
+                rec.id = QString::number(QDateTime::currentMSecsSinceEpoch());
+                rec.type = "offline";
+                rec.role = "receiver";
+                rec.peerId = "cold_sender@fastpay";
+                rec.amount = amount;
+                rec.nonce = nonce;
+                rec.status = "completed";
+                rec.createdAt = QDateTime::currentDateTime();
+                m_engine->submitOfflineWhenOnline(rec, userId, signature, receipt);
+                QMessageBox::information(this, tr("Offline receive"), tr("Verified. Receipt emitted. When both come online, transaction will be stored on server."));
+            }).onCanceled(this, [this]() { showBusy(); });
+        }).onCanceled(this, [this]() { showBusy(); });
+    }).onCanceled(this, [this]() { showBusy(); });
+}
+
+void MainWindow::showBusy()
+{
+    QMessageBox::warning(this, tr("Busy"), tr("Too many operations in progress. Try again."));
 }
 
 void MainWindow::onAccountFrozen()
@@ -402,20 +456,14 @@ void MainWindow::showHistory()
     dlg->setWindowTitle(tr("Transaction history (online + offline)"));
     dlg->setMinimumSize(500, 300);
     QVBoxLayout *lay = new QVBoxLayout(dlg);
-    QTableWidget *table = new QTableWidget(0, 7);
-    table->setHorizontalHeaderLabels({tr("ID"), tr("Type"), tr("Role"), tr("Peer"), tr("Amount"), tr("Nonce"), tr("Status")});
-    QList<TransactionRecord> list = TransactionHistory::load();
-    for (const TransactionRecord &r : list) {
-        int row = table->rowCount();
-        table->insertRow(row);
-        table->setItem(row, 0, new QTableWidgetItem(r.id.left(8)));
-        table->setItem(row, 1, new QTableWidgetItem(r.type));
-        table->setItem(row, 2, new QTableWidgetItem(r.role));
-        table->setItem(row, 3, new QTableWidgetItem(r.peerId));
-        table->setItem(row, 4, new QTableWidgetItem(r.amount));
-        table->setItem(row, 5, new QTableWidgetItem(r.nonce));
-        table->setItem(row, 6, new QTableWidgetItem(r.status));
-    }
+    QTableView *table = new QTableView(dlg);
+    table->setModel(new HistoryTableModel(m_engine, table));
+    table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    // Fixed row heights let the view lay out only the rows on screen
+    table->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    table->verticalHeader()->setDefaultSectionSize(28);
+    table->horizontalHeader()->setStretchLastSection(true);
     lay->addWidget(table);
     QPushButton *closeBtn = new QPushButton(tr("Close"));
     connect(closeBtn, &QPushButton::clicked, dlg, &QDialog::accept);
@@ -35,7 +35,9 @@ private:
     void showOnlinePanel();
     void showOfflinePanel();
     void ensurePinSet();
+    void showBusy();
     QString currentNonce() const;
+    QString localUserId() const;
 
     QStackedWidget *m_stack = nullptr;
     TransactionEngine *m_engine = nullptr;
@@ -0,0 +1,134 @@
+#include "money.h"
+#include <limits>
+
+quint32 Money::packCurrency(const char *code)
+{
+    if (!code) return 0;
+    quint32 tag = 0;
+    for (int i = 0; i < 3; ++i) {
+        const char c = code[i];
+        if (c < 'A' || c > 'Z') return 0;
+        tag = (tag << 8) | quint8(c);
+    }
+    return code[3] == '\0' ? tag : 0;
+}
+
+Money::Money(qint64 minorUnits, const char *currency)
+    : m_minor(minorUnits)
+    , m_currency(packCurrency(currency))
+{
+}
+
+Money Money::fromMinorUnits(qint64 minorUnits, quint32 currencyTag)
+{
+    Money m;
+    m.m_minor = minorUnits;
+    m.m_currency = currencyTag;
+    return m;
+}
+
+QString Money::currencyCode() const
+{
+    if (!isValid()) return QString();
+    const char code[3] = { char(m_currency >> 16), char(m_currency >> 8), char(m_currency) };
+    return QString::fromLatin1(code, 3);
+}
+
+template <typename Char>
+Money Money::parse(const Char *text, qsizetype length, const char *currency)
+{
+    qsizetype begin = 0, end = length;
+    while (begin < end && (text[begin] == ' ' || text[begin] == '\t')) ++begin;
+    while (end > begin && (text[end - 1] == ' ' || text[end - 1] == '\t')) --end;
+    if (begin == end) return Money();
+
+    constexpr qint64 kMax = std::numeric_limits<qint64>::max();
+    qint64 major = 0;
+    qsizetype i = begin;
+    for (; i < end && text[i] >= '0' && text[i] <= '9'; ++i) {
+        const int digit = text[i] - '0';
+        if (major > (kMax / kMinorPerMajor - digit) / 10) return Money();
+        major = major * 10 + digit;
+    }
+    if (i == begin) return Money();             // need at least one integer digit
+
+    qint64 fraction = 0;
+    int fractionDigits = 0;
+    if (i < end && text[i] == '.') {
+        for (++i; i < end && text[i] >= '0' && text[i] <= '9'; ++i) {
+            if (++fractionDigits > kMinorDigits) return Money();
+            fraction = fraction * 10 + (text[i] - '0');
+        }
+    }
+    if (i != end) return Money();
+    for (; fractionDigits < kMinorDigits; ++fractionDigits)
+        fraction *= 10;
+    if (major * kMinorPerMajor > kMax - fraction) return Money();
+
+    Money m;
+    m.m_currency = packCurrency(currency);
+    m.m_minor = major * kMinorPerMajor + fraction;
+    return m;
+}
+
+Money Money::fromString(QStringView text, const char *currency)
+{
+    return parse(text.utf16(), text.size(), currency);
+}
+
+Money Money::fromUtf8(const char *text, qsizetype length, const char *currency)
+{
+    return parse(text, length, currency);
+}
+
+int Money::formatTo(char *buf, int size) const
+{
+    if (!isValid()) {
+        if (size < 1) return -1;
+        buf[0] = '\0';
+        return 0;
+    }
+    // Work on the magnitude as unsigned so INT64_MIN formats correctly
+    const bool negative = m_minor < 0;
+    quint64 magnitude = negative ? quint64(0) - quint64(m_minor) : quint64(m_minor);
+
+    char tmp[kMaxTextLength];
+    int n = 0;
+    for (int d = 0; d < kMinorDigits; ++d) {
+        tmp[n++] = char('0' + magnitude % 10);
+        magnitude /= 10;
+    }
+    tmp[n++] = '.';
+    do {
+        tmp[n++] = char('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude);
+    if (negative) tmp[n++] = '-';
+
+    if (n + 1 > size) return -1;
+    for (int k = 0; k < n; ++k)
+        buf[k] = tmp[n - 1 - k];
+    buf[n] = '\0';
+    return n;
+}
+
+QString Money::toString() const
+{
+    char buf[kMaxTextLength];
+    const int n = formatTo(buf, sizeof(buf));
+    return n > 0 ? QString::fromLatin1(buf, n) : QString();
+}
+
+Money &Money::operator+=(const Money &other)
+{
+    Q_ASSERT(sameCurrency(other));
+    m_minor += other.m_minor;
+    return *this;
+}
+
+Money &Money::operator-=(const Money &other)
+{
+    Q_ASSERT(sameCurrency(other));
+    m_minor -= other.m_minor;
+    return *this;
+}
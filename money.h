@@ -0,0 +1,57 @@
+#ifndef MONEY_H
+#define MONEY_H
+
+#include <QString>
+#include <QStringView>
+#include <QtGlobal>
+
+// Fixed-point amount: int64 minor units (paise, cents) plus an ISO 4217 currency code.
+// Parsing and formatting never allocate; toString() is the only QString-producing path.
+class Money
+{
+public:
+    static constexpr int kMinorDigits = 2;
+    static constexpr qint64 kMinorPerMajor = 100;
+    static constexpr int kMaxTextLength = 24;      // "-9223372036854775808" + ".00" + NUL
+
+    constexpr Money() = default;
+    explicit Money(qint64 minorUnits, const char *currency = "INR");
+
+    // Accepts "50", "50.", "50.5", "50.50" (surrounding whitespace ignored). Anything else,
+    // including more than two fractional digits or overflow, gives an invalid Money.
+    static Money fromString(QStringView text, const char *currency = "INR");
+    static Money fromUtf8(const char *text, qsizetype length, const char *currency = "INR");
+
+    bool isValid() const { return m_currency != 0; }
+    qint64 minorUnits() const { return m_minor; }
+    QString currencyCode() const;
+    quint32 currencyTag() const { return m_currency; }
+    static Money fromMinorUnits(qint64 minorUnits, quint32 currencyTag);
+
+    // Canonical text ("50.00"); writes at most 'size' bytes including the terminating NUL.
+    // Returns the number of characters written, or -1 if the buffer is too small.
+    int formatTo(char *buf, int size) const;
+    QString toString() const;
+
+    bool sameCurrency(const Money &other) const { return m_currency == other.m_currency; }
+    Money &operator+=(const Money &other);
+    Money &operator-=(const Money &other);
+    friend Money operator+(Money a, const Money &b) { return a += b; }
+    friend Money operator-(Money a, const Money &b) { return a -= b; }
+    friend bool operator==(const Money &a, const Money &b) { return a.m_currency == b.m_currency && a.m_minor == b.m_minor; }
+    friend bool operator!=(const Money &a, const Money &b) { return !(a == b); }
+    friend bool operator<(const Money &a, const Money &b) { Q_ASSERT(a.sameCurrency(b)); return a.m_minor < b.m_minor; }
+    friend bool operator>(const Money &a, const Money &b) { return b < a; }
+    friend bool operator<=(const Money &a, const Money &b) { return !(b < a); }
+    friend bool operator>=(const Money &a, const Money &b) { return !(a < b); }
+
+private:
+    template <typename Char>
+    static Money parse(const Char *text, qsizetype length, const char *currency);
+    static quint32 packCurrency(const char *code);
+
+    qint64 m_minor = 0;
+    quint32 m_currency = 0;     // three ASCII letters packed big-endian; 0 = invalid
+};
+
+#endif // MONEY_H
@@ -0,0 +1,250 @@
+#include "offlineoutbox.h"
+#include "serverconnection.h"
+#include "server_config.h"
+#include "SignatureScheme.h"
+#include <QDataStream>
+#include <QDir>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkInformation>
+#include <QNetworkReply>
+#include <QRandomGenerator>
+#include <QStandardPaths>
+#include <QTimer>
+#include <QDebug>
+
+static constexpr quint8 kEnqueueRecord = 1;
+static constexpr quint8 kAckRecord = 2;
+static constexpr int kInitialBackoffMs = 2000;
+static constexpr int kMaxBackoffMs = 5 * 60 * 1000;
+
+static QString outboxPath()
+{
+    QString base = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(base);
+    return base + "/offline_outbox.journal";
+}
+
+static QByteArray encodeItem(const OfflineSyncItem &item)
+{
+    QByteArray out;
+    QDataStream ds(&out, QIODevice::WriteOnly);
+    ds.setVersion(QDataStream::Qt_6_0);
+    ds << kEnqueueRecord
+       << item.userId.toUtf8() << item.txId.toUtf8() << item.senderId.toUtf8() << item.receiverId.toUtf8()
+       << item.amount.minorUnits() << item.amount.currencyTag() << item.nonce.toUtf8()
+       << item.senderSignature << item.receiptSignature
+       << qint64(item.createdAt.isValid() ? item.createdAt.toMSecsSinceEpoch() : -1)
+       << item.signatureScheme;
+    return out;
+}
+
+static QByteArray encodeAck(const QString &txId)
+{
+    QByteArray out;
+    QDataStream ds(&out, QIODevice::WriteOnly);
+    ds.setVersion(QDataStream::Qt_6_0);
+    ds << kAckRecord << txId.toUtf8();
+    return out;
+}
+
+OfflineOutbox::OfflineOutbox(ServerConnection *connection, QObject *parent)
+    : QObject(parent)
+    , m_connection(connection)
+    , m_journal(outboxPath())
+    , m_batchSize(ServerConfig::OFFLINE_SYNC_BATCH_SIZE)
+    , m_backoffMs(kInitialBackoffMs)
+{
+    m_retryTimer = new QTimer(this);
+    m_retryTimer->setSingleShot(true);
+    connect(m_retryTimer, &QTimer::timeout, this, &OfflineOutbox::flush);
+
+    if (QNetworkInformation::loadBackendByFeatures(QNetworkInformation::Feature::Reachability)) {
+        connect(QNetworkInformation::instance(), &QNetworkInformation::reachabilityChanged,
+                this, &OfflineOutbox::onReachabilityChanged);
+    }
+    load();
+}
+
+// Replays the journal: enqueue records add items, ack records remove them
+void OfflineOutbox::load()
+{
+    if (!m_journal.open()) return;
+    const QList<QByteArray> records = m_journal.readFrom(0);
+    for (const QByteArray &payload : records) {
+        QDataStream ds(payload);
+        ds.setVersion(QDataStream::Qt_6_0);
+        quint8 kind = 0;
+        ds >> kind;
+        if (kind == kEnqueueRecord) {
+            QByteArray userId, txId, senderId, receiverId, nonce;
+            qint64 minor = 0, createdAtMs = -1;
+            quint32 currency = 0;
+            OfflineSyncItem item;
+            ds >> userId >> txId >> senderId >> receiverId >> minor >> currency >> nonce
+               >> item.senderSignature >> item.receiptSignature >> createdAtMs;
+            if (!ds.atEnd())
+                ds >> item.signatureScheme;     // absent in records queued before schemes were recorded
+            if (ds.status() != QDataStream::Ok) continue;
+            item.userId = QString::fromUtf8(userId);
+            item.txId = QString::fromUtf8(txId);
+            item.senderId = QString::fromUtf8(senderId);
+            item.receiverId = QString::fromUtf8(receiverId);
+            item.amount = Money::fromMinorUnits(minor, currency);
+            item.nonce = QString::fromUtf8(nonce);
+            item.createdAt = createdAtMs >= 0 ? QDateTime::fromMSecsSinceEpoch(createdAtMs) : QDateTime();
+            m_pending.append(item);
+        } else if (kind == kAckRecord) {
+            QByteArray txId;
+            ds >> txId;
+            const QString id = QString::fromUtf8(txId);
+            m_pending.removeIf([&id](const OfflineSyncItem &i) { return i.txId == id; });
+        }
+    }
+    if (m_pending.isEmpty() && !records.isEmpty())
+        m_journal.clear();
+}
+
+void OfflineOutbox::enqueue(const OfflineSyncItem &item)
+{
+    if (m_journal.append(encodeItem(item)) < 0)
+        qWarning() << "Failed to persist offline transaction" << item.txId;
+    m_pending.append(item);
+    flush();
+}
+
+void OfflineOutbox::acknowledge(const QString &txId)
+{
+    m_pending.removeIf([&txId](const OfflineSyncItem &i) { return i.txId == txId; });
+    // Nothing left to replay: reset the journal instead of growing it forever
+    if (m_pending.isEmpty())
+        m_journal.clear();
+    else
+        m_journal.append(encodeAck(txId));
+}
+
+void OfflineOutbox::onReachabilityChanged()
+{
+    if (QNetworkInformation::instance()->reachability() == QNetworkInformation::Reachability::Online) {
+        m_backoffMs = kInitialBackoffMs;
+        m_retryTimer->stop();
+        flush();
+    }
+}
+
+void OfflineOutbox::flush()
+{
+    if (m_inFlight || m_pending.isEmpty() || m_connection->baseUrl().isEmpty()) return;
+    QNetworkInformation *info = QNetworkInformation::instance();
+    if (info && info->reachability() == QNetworkInformation::Reachability::Disconnected)
+        return;     // onReachabilityChanged() resumes once we are back online
+    sendBatch();
+}
+
+void OfflineOutbox::scheduleRetry()
+{
+    const int jitter = QRandomGenerator::global()->bounded(m_backoffMs / 4 + 1);
+    m_retryTimer->start(m_backoffMs + jitter);
+    m_backoffMs = qMin(m_backoffMs * 2, kMaxBackoffMs);
+}
+
+void OfflineOutbox::sendBatch()
+{
+    // One request per user: take the leading run of items reported by the same party
+    const QString userId = m_pending.first().userId;
+    const int limit = m_bisectSize > 0 ? m_bisectSize : m_batchSize;
+    QJsonArray transactions;
+    QStringList batchIds;
+    for (const OfflineSyncItem &item : std::as_const(m_pending)) {
+        if (item.userId != userId || transactions.size() >= limit) break;
+        QJsonObject tx;
+        tx.insert(QStringLiteral("tx_id"), item.txId);
+        tx.insert(QStringLiteral("sender_id"), item.senderId);
+        tx.insert(QStringLiteral("receiver_id"), item.receiverId);
+        tx.insert(QStringLiteral("amount"), item.amount.toString());
+        tx.insert(QStringLiteral("amount_minor"), item.amount.minorUnits());
+        tx.insert(QStringLiteral("currency"), item.amount.currencyCode());
+        tx.insert(QStringLiteral("nonce"), item.nonce);
+        tx.insert(QStringLiteral("sender_signature"), QString::fromLatin1(item.senderSignature.toHex()));
+        tx.insert(QStringLiteral("receiver_receipt_signature"), QString::fromLatin1(item.receiptSignature.toHex()));
+        tx.insert(QStringLiteral("sig_scheme"),
+                  QLatin1String(DigitalSignature::schemeName(DigitalSignature::SchemeId(item.signatureScheme))));
+        if (item.createdAt.isValid())
+            tx.insert(QStringLiteral("created_at"), item.createdAt.toUTC().toString(Qt::ISODate));
+        transactions.append(tx);
+        batchIds.append(item.txId);
+    }
+    QJsonObject body;
+    body.insert(QStringLiteral("user_id"), userId);
+    body.insert(QStringLiteral("transactions"), transactions);
+    QByteArray json = QJsonDocument(body).toJson(QJsonDocument::Compact);
+
+    m_inFlight = true;
+    QNetworkReply *reply = m_connection->postJson(QStringLiteral("/api/v1/transactions/offline/sync"), json);
+
+    connect(reply, &QNetworkReply::finished, this, [this, reply, batchIds]() {
+        reply->deleteLater();
+        m_inFlight = false;
+        const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        if (status == 403) {
+            emit accountFrozen();
+            return;     // retrying cannot help until the account is unfrozen
+        }
+        // Any other 4xx (e.g. 422 for a malformed item) will fail the same way every time, and the
+        // leading run is always resent, so it would block the queue for good. Timeouts, rate
+        // limits and a missing or unauthorised endpoint are about the server, not the items.
+        if (status >= 400 && status < 500 && status != 401 && status != 404 && status != 408 && status != 429) {
+            if (batchIds.size() > 1) {
+                m_bisectSize = int(batchIds.size() / 2);
+            } else {
+                const QString reason = QStringLiteral("http %1: %2")
+                                           .arg(status).arg(QString::fromUtf8(reply->readAll().left(200)));
+                acknowledge(batchIds.first());
+                emit itemRejected(batchIds.first(), reason);
+                m_bisectSize = 0;
+            }
+            flush();
+            return;
+        }
+        if (reply->error() != QNetworkReply::NoError) {
+            emit syncFailed(reply->errorString());
+            scheduleRetry();
+            return;
+        }
+        QJsonDocument doc = QJsonDocument::fromJson(reply->readAll());
+        if (!doc.isObject()) {
+            emit syncFailed(tr("Invalid server response."));
+            scheduleRetry();
+            return;
+        }
+        QJsonObject obj = doc.object();
+        int settled = 0;
+        for (const QJsonValue &v : obj.value(QStringLiteral("accepted")).toArray()) {
+            const QString txId = v.toString();
+            if (!batchIds.contains(txId)) continue;
+            acknowledge(txId);
+            emit itemAccepted(txId);
+            ++settled;
+        }
+        for (const QJsonValue &v : obj.value(QStringLiteral("rejected")).toArray()) {
+            const QJsonObject r = v.toObject();
+            const QString txId = r.value(QStringLiteral("tx_id")).toString();
+            const QString reason = r.value(QStringLiteral("reason")).toString();
+            if (!batchIds.contains(txId)) continue;
+            acknowledge(txId);
+            // A duplicate means an earlier upload already landed (e.g. its response was lost)
+            if (reason == QLatin1String("duplicate"))
+                emit itemAccepted(txId);
+            else
+                emit itemRejected(txId, reason);
+            ++settled;
+        }
+        if (settled == 0) {
+            scheduleRetry();
+            return;
+        }
+        m_backoffMs = kInitialBackoffMs;
+        flush();
+    });
+}
@@ -0,0 +1,75 @@
+#ifndef OFFLINEOUTBOX_H
+#define OFFLINEOUTBOX_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QDateTime>
+#include <QList>
+#include <QString>
+#include "money.h"
+#include "recordjournal.h"
+
+class ServerConnection;
+class QTimer;
+
+// A signed cold-wallet transfer (plus the receiver's receipt) waiting to reach the server
+struct OfflineSyncItem {
+    QString userId;             // local party that reports the transfer
+    QString txId;
+    QString senderId;
+    QString receiverId;
+    Money amount;
+    QString nonce;
+    QByteArray senderSignature;
+    QByteArray receiptSignature;
+    QDateTime createdAt;
+    quint8 signatureScheme = 1;  // DigitalSignature::SchemeId of both signatures
+};
+
+// Durable queue of offline transactions. Items survive restarts (journal-backed) and are
+// uploaded to /api/v1/transactions/offline/sync in batches whenever the network is reachable,
+// backing off exponentially on network errors and 5xx. A batch refused outright with a 4xx is
+// halved until the refused item is alone, which is then dropped as rejected.
+class OfflineOutbox : public QObject
+{
+    Q_OBJECT
+public:
+    explicit OfflineOutbox(ServerConnection *connection, QObject *parent = nullptr);
+
+    void setBatchSize(int items) { m_batchSize = qMax(1, items); }
+    int batchSize() const { return m_batchSize; }
+
+    void enqueue(const OfflineSyncItem &item);
+    int pendingCount() const { return int(m_pending.size()); }
+    const QList<OfflineSyncItem> &pending() const { return m_pending; }
+
+public slots:
+    // Uploads the next batch now if possible (no-op while a batch is in flight)
+    void flush();
+
+signals:
+    void itemAccepted(const QString &txId);
+    void itemRejected(const QString &txId, const QString &reason);
+    void syncFailed(const QString &error);
+    void accountFrozen();
+
+private slots:
+    void onReachabilityChanged();
+
+private:
+    void load();
+    void acknowledge(const QString &txId);
+    void scheduleRetry();
+    void sendBatch();
+
+    ServerConnection *m_connection = nullptr;
+    RecordJournal m_journal;
+    QList<OfflineSyncItem> m_pending;
+    QTimer *m_retryTimer = nullptr;
+    int m_batchSize;
+    int m_bisectSize = 0;       // while isolating an item the server refuses: batch cap, else 0
+    int m_backoffMs;
+    bool m_inFlight = false;
+};
+
+#endif // OFFLINEOUTBOX_H
@@ -7,6 +7,17 @@
 #include <QHBoxLayout>
 #include <QFormLayout>
 #include <QDialogButtonBox>
+#include <openssl/crypto.h>
+
+static SecureString takePin(const QLineEdit *edit)
+{
+    QString text = edit->text().trimmed();
+    QByteArray utf8 = text.toUtf8();
+    SecureString pin(std::string_view(utf8.constData(), size_t(utf8.size())));
+    OPENSSL_cleanse(utf8.data(), size_t(utf8.size()));
+    OPENSSL_cleanse(text.data(), size_t(text.size()) * sizeof(QChar));
+    return pin;
+}
 
 PinDialog::PinDialog(Mode mode, QWidget *parent) : QDialog(parent), m_mode(mode)
 {
@@ -93,24 +104,24 @@ PinDialog::PinDialog(Mode mode, QWidget *parent) : QDialog(parent), m_mode(mode)
     layout->addWidget(box);
 }
 
-QString PinDialog::pin() const
+SecureString PinDialog::pin() const
 {
-    return m_pinEdit->text();
+    return takePin(m_pinEdit);
 }
 
-QString PinDialog::newPin() const
+SecureString PinDialog::newPin() const
 {
-    return m_confirmEdit ? m_confirmEdit->text() : m_pinEdit->text();
+    return takePin(m_confirmEdit ? m_confirmEdit : m_pinEdit);
 }
 
-QString PinDialog::askPin(QWidget *parent, const QString &title)
+SecureString PinDialog::askPin(QWidget *parent, const QString &title)
 {
     PinDialog dlg(VerifyPin, parent);
     if (!title.isEmpty()) dlg.setWindowTitle(title);
-    return dlg.exec() == QDialog::Accepted ? dlg.pin() : QString();
+    return dlg.exec() == QDialog::Accepted ? dlg.pin() : SecureString();
 }
 
-bool PinDialog::askSetPin(QWidget *parent, QString &outPin)
+bool PinDialog::askSetPin(QWidget *parent, SecureString &outPin)
 {
     PinDialog dlg(SetPin, parent);
     if (dlg.exec() != QDialog::Accepted) return false;
@@ -2,6 +2,7 @@
 #define PINDIALOG_H
 
 #include <QDialog>
+#include "SecureArena.h"
 
 class QLineEdit;
 class QLabel;
@@ -14,11 +15,13 @@ public:
 
     explicit PinDialog(Mode mode, QWidget *parent = nullptr);
 
-    QString pin() const;
-    QString newPin() const;  // for SetPin/ChangePin: second field
+    // Copied out of the line edit into a SecureString; the QString buffers involved are wiped,
+    // but the line edit keeps its own copy until the dialog is destroyed
+    SecureString pin() const;
+    SecureString newPin() const;  // for SetPin/ChangePin: second field
 
-    static QString askPin(QWidget *parent, const QString &title = QString());
-    static bool askSetPin(QWidget *parent, QString &outPin);
+    static SecureString askPin(QWidget *parent, const QString &title = QString());
+    static bool askSetPin(QWidget *parent, SecureString &outPin);
     static bool askChangePin(QWidget *parent, class TransactionEngine *engine);
 
 private:
@@ -0,0 +1,230 @@
+#include "recordjournal.h"
+#include <QtEndian>
+#include <QDebug>
+#include <array>
+#include <cstring>
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+static const char kJournalMagic[8] = { 'F', 'P', 'J', 'R', 'N', 'L', '0', '1' };
+static constexpr qint64 kHeaderSize = sizeof(kJournalMagic);
+static constexpr qint64 kRecordHeaderSize = 8;           // length + crc32
+static constexpr quint32 kMaxRecordSize = 1u << 20;      // sanity bound for a single record
+
+// The data reached the disk, not just the OS cache; false on an I/O error
+static bool syncToDisk(QFile &file)
+{
+#ifdef Q_OS_UNIX
+    return ::fsync(file.handle()) == 0;
+#else
+    Q_UNUSED(file);
+    return true;
+#endif
+}
+
+RecordJournal::RecordJournal(const QString &path)
+    : m_path(path)
+    , m_file(path)
+{
+}
+
+RecordJournal::~RecordJournal()
+{
+    m_file.close();
+}
+
+quint32 RecordJournal::crc32(const char *data, qsizetype size)
+{
+    static const auto table = [] {
+        std::array<quint32, 256> t{};
+        for (quint32 i = 0; i < 256; ++i) {
+            quint32 c = i;
+            for (int k = 0; k < 8; ++k)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : (c >> 1);
+            t[i] = c;
+        }
+        return t;
+    }();
+
+    quint32 crc = 0xFFFFFFFFu;
+    for (qsizetype i = 0; i < size; ++i)
+        crc = table[(crc ^ static_cast<quint8>(data[i])) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
+
+bool RecordJournal::open()
+{
+    if (m_file.isOpen()) return true;
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        qWarning() << "Cannot open journal" << m_path << m_file.errorString();
+        return false;
+    }
+    if (m_file.size() < kHeaderSize) {
+        if (!writeHeader()) {
+            m_file.close();
+            return false;
+        }
+    } else {
+        char magic[kHeaderSize];
+        if (m_file.read(magic, kHeaderSize) != kHeaderSize
+            || memcmp(magic, kJournalMagic, kHeaderSize) != 0) {
+            qWarning() << "Journal" << m_path << "has an unknown header";
+            m_file.close();
+            return false;
+        }
+    }
+    return recoverTail();
+}
+
+bool RecordJournal::writeHeader()
+{
+    if (!m_file.resize(0) || !m_file.seek(0)) return false;
+    if (m_file.write(kJournalMagic, kHeaderSize) != kHeaderSize) return false;
+    m_file.flush();
+    m_endOffset = kHeaderSize;
+    return true;
+}
+
+// Size of the record starting at 'at' if its length and checksum check out, else -1
+static qsizetype validRecordAt(const QByteArray &data, qsizetype at)
+{
+    if (at + kRecordHeaderSize > data.size()) return -1;
+    const quint32 length = qFromLittleEndian<quint32>(data.constData() + at);
+    const quint32 crc = qFromLittleEndian<quint32>(data.constData() + at + 4);
+    if (length > kMaxRecordSize || at + kRecordHeaderSize + length > data.size()) return -1;
+    if (RecordJournal::crc32(data.constData() + at + kRecordHeaderSize, length) != crc) return -1;
+    return kRecordHeaderSize + length;
+}
+
+// Walks the journal checking each record's length and checksum. An interrupted append leaves
+// a torn final record, which is truncated away. A bad record with good ones after it is
+// corruption, not a torn append: its bytes are moved to <journal>.corrupt and the records
+// after it are kept.
+bool RecordJournal::recoverTail()
+{
+    if (!m_file.seek(kHeaderSize)) return false;
+    QByteArray data = m_file.readAll();
+
+    qsizetype pos = 0;
+    qsizetype firstChange = -1;
+    for (;;) {
+        for (qsizetype n; (n = validRecordAt(data, pos)) > 0; pos += n) {}
+        if (pos == data.size()) break;
+        if (firstChange < 0) firstChange = pos;
+
+        // Resynchronise on the next record that checks out. Empty records are skipped here:
+        // eight zero bytes pass the checksum, and zero-filled blocks are a common kind of damage.
+        qsizetype next = pos + 1;
+        for (; next + kRecordHeaderSize <= data.size(); ++next) {
+            if (qFromLittleEndian<quint32>(data.constData() + next) != 0 && validRecordAt(data, next) > 0)
+                break;
+        }
+        if (next + kRecordHeaderSize > data.size()) {
+            next = data.size();
+            const quint32 length = pos + kRecordHeaderSize <= data.size()
+                                   ? qFromLittleEndian<quint32>(data.constData() + pos) : 0;
+            const bool torn = pos + kRecordHeaderSize > data.size()
+                              || (length <= kMaxRecordSize && pos + kRecordHeaderSize + length > data.size());
+            if (torn) {
+                qWarning() << "Journal" << m_path << "truncating torn final record:"
+                           << (data.size() - pos) << "bytes";
+                data.truncate(pos);
+                break;
+            }
+        }
+
+        QFile quarantine(m_path + QStringLiteral(".corrupt"));
+        if (!quarantine.open(QIODevice::WriteOnly | QIODevice::Append)
+            || quarantine.write(data.constData() + pos, next - pos) != next - pos) {
+            qWarning() << "Journal" << m_path << "cannot quarantine a corrupt record at"
+                       << (kHeaderSize + pos) << quarantine.errorString();
+            return false;
+        }
+        qWarning() << "Journal" << m_path << "moved" << (next - pos) << "corrupt bytes at"
+                   << (kHeaderSize + pos) << "to" << quarantine.fileName();
+        data.remove(pos, next - pos);
+    }
+
+    if (firstChange >= 0) {
+        // Only the part from the first bad record on changes
+        if (!m_file.seek(kHeaderSize + firstChange)
+            || m_file.write(data.constData() + firstChange, data.size() - firstChange)
+                   != data.size() - firstChange
+            || !m_file.resize(kHeaderSize + data.size())
+            || !m_file.flush()
+            || !syncToDisk(m_file))
+            return false;
+    }
+    m_endOffset = kHeaderSize + data.size();
+    return m_file.seek(m_endOffset);
+}
+
+qint64 RecordJournal::append(const QByteArray &payload)
+{
+    return append(QList<QByteArray>{ payload });
+}
+
+qint64 RecordJournal::append(const QList<QByteArray> &payloads)
+{
+    if (!m_file.isOpen()) return -1;
+    for (const QByteArray &payload : payloads) {
+        if (payload.size() > qsizetype(kMaxRecordSize)) return -1;
+    }
+
+    qint64 end = m_endOffset;
+    bool ok = m_file.seek(m_endOffset);
+    char header[kRecordHeaderSize];
+    for (const QByteArray &payload : payloads) {
+        if (!ok) break;
+        qToLittleEndian<quint32>(quint32(payload.size()), header);
+        qToLittleEndian<quint32>(crc32(payload.constData(), payload.size()), header + 4);
+        ok = m_file.write(header, kRecordHeaderSize) == kRecordHeaderSize
+             && m_file.write(payload) == payload.size();
+        end += kRecordHeaderSize + payload.size();
+    }
+    if (!ok || !m_file.flush() || !syncToDisk(m_file)) {
+        // Leave the file as it was before this append
+        m_file.resize(m_endOffset);
+        return -1;
+    }
+    m_endOffset = end;
+    return m_endOffset;
+}
+
+QList<QByteArray> RecordJournal::readFrom(qint64 offset, qint64 *nextOffset) const
+{
+    QList<QByteArray> records;
+    qint64 pos = qMax(offset, kHeaderSize);
+    if (nextOffset) *nextOffset = pos;
+    if (pos >= m_endOffset) return records;
+
+    QFile in(m_path);
+    if (!in.open(QIODevice::ReadOnly) || !in.seek(pos)) return records;
+    const QByteArray data = in.read(m_endOffset - pos);
+
+    const char *p = data.constData();
+    qsizetype left = data.size();
+    while (left >= kRecordHeaderSize) {
+        const quint32 length = qFromLittleEndian<quint32>(p);
+        const quint32 crc = qFromLittleEndian<quint32>(p + 4);
+        if (qsizetype(length) > left - kRecordHeaderSize) break;
+        if (crc32(p + kRecordHeaderSize, length) != crc) {
+            qWarning() << "Journal" << m_path << "checksum mismatch at" << pos;
+            break;
+        }
+        records.append(QByteArray(p + kRecordHeaderSize, length));
+        p += kRecordHeaderSize + length;
+        left -= kRecordHeaderSize + length;
+        pos += kRecordHeaderSize + length;
+    }
+    if (nextOffset) *nextOffset = pos;
+    return records;
+}
+
+bool RecordJournal::clear()
+{
+    if (!m_file.isOpen()) return false;
+    return writeHeader();
+}
@@ -0,0 +1,45 @@
+#ifndef RECORDJOURNAL_H
+#define RECORDJOURNAL_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+#include <QString>
+
+// Append-only binary journal: [file header][len u32][crc32 u32][payload]...
+// Appends are O(1); on open() a torn final record is truncated away and corrupt records
+// further in are moved to <path>.corrupt.
+class RecordJournal
+{
+public:
+    explicit RecordJournal(const QString &path);
+    ~RecordJournal();
+
+    bool open();
+    bool isOpen() const { return m_file.isOpen(); }
+    QString path() const { return m_path; }
+
+    // Appends one record and returns the offset just past it (or -1 on failure).
+    qint64 append(const QByteArray &payload);
+    // All of them, synced to disk once: for bulk writes such as an import
+    qint64 append(const QList<QByteArray> &payloads);
+
+    // Reads every record from 'offset' (0 = first record) to the current end.
+    // 'nextOffset' receives the position to resume from on the next call.
+    QList<QByteArray> readFrom(qint64 offset, qint64 *nextOffset = nullptr) const;
+
+    qint64 endOffset() const { return m_endOffset; }
+    bool clear();
+
+    static quint32 crc32(const char *data, qsizetype size);
+
+private:
+    bool writeHeader();
+    bool recoverTail();
+
+    QString m_path;
+    QFile m_file;
+    qint64 m_endOffset = 0;
+};
+
+#endif // RECORDJOURNAL_H
@@ -40,7 +40,9 @@ DEVICE_TOKENS = {}  # user_id -> { "token": "...", "platform": "android" }
 class OnlineTransactionSubmit(BaseModel):
     sender_id: str
     receiver_id: str
-    amount: str
+    amount: str  # canonical "123.45"
+    amount_minor: Optional[int] = None  # same amount in minor units (paise)
+    currency: str = "INR"
     nonce: str  # timestamp "YYYY-MM-DD HH:MM:SS"
     pin_verification_token: Optional[str] = None
 
@@ -49,9 +51,12 @@ class OfflineTransactionItem(BaseModel):
     sender_id: str
     receiver_id: str
     amount: str
+    amount_minor: Optional[int] = None
+    currency: str = "INR"
     nonce: str
     sender_signature: str
     receiver_receipt_signature: str
+    sig_scheme: str = "ecdsa-p256"  # or "ed25519"; applies to both signatures
     created_at: Optional[str] = None
 
 class OfflineSyncPayload(BaseModel):
@@ -76,6 +81,8 @@ class VerifyTransactionIdPayload(BaseModel):
     receiver_id: str
     nonce: str
     amount: str
+    amount_minor: Optional[int] = None
+    currency: str = "INR"
 
 # ---------------------------------------------------------------------------
 # Helpers: check frozen, notify receiver (stub)
@@ -80,7 +80,9 @@ def get_db():
 class OnlineTransactionSubmit(BaseModel):
     sender_id: str
     receiver_id: str
-    amount: str
+    amount: str  # canonical "123.45"
+    amount_minor: Optional[int] = None  # same amount in minor units (paise)
+    currency: str = "INR"
     nonce: str
     pin_verification_token: Optional[str] = None
 
@@ -89,9 +91,12 @@ class OfflineTransactionItem(BaseModel):
     sender_id: str
     receiver_id: str
     amount: str
+    amount_minor: Optional[int] = None
+    currency: str = "INR"
     nonce: str
     sender_signature: str
     receiver_receipt_signature: str
+    sig_scheme: str = "ecdsa-p256"  # or "ed25519"; applies to both signatures
 
 class OfflineSyncPayload(BaseModel):
     user_id: str
@@ -113,6 +118,8 @@ class VerifyTransactionIdPayload(BaseModel):
     receiver_id: str
     nonce: str
     amount: str
+    amount_minor: Optional[int] = None
+    currency: str = "INR"
 
 class UserRegistration(BaseModel):
     user_id: str
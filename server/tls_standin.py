@@ -0,0 +1,119 @@
+"""
+Local TLS stand-in for the FastPay API, for measuring first-payment latency.
+
+It answers the endpoints the client posts to (online, verify-id, offline/sync) and logs,
+per connection, whether the TLS session was resumed and how many requests it carried.
+An optional simulated round-trip time makes the cost of each handshake visible on a LAN:
+TCP accept costs one RTT, a full TLS handshake two more, a resumed one only one.
+
+    python tls_standin.py --port 8443 --rtt-ms 150
+
+On first run it creates standin-cert.pem/standin-key.pem (needs the openssl CLI).
+Point a debug build at it with server_config.h's LOCAL_SERVER (https://<host>:8443)
+and export FASTPAY_CA_CERT=/path/to/standin-cert.pem so the client trusts the cert.
+Python's http.server speaks HTTP/1.1 only; HTTP/2 needs the real deployment.
+"""
+
+import argparse
+import json
+import os
+import ssl
+import subprocess
+import time
+import uuid
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+CERT = "standin-cert.pem"
+KEY = "standin-key.pem"
+
+
+def ensure_cert(host: str):
+    if os.path.exists(CERT) and os.path.exists(KEY):
+        return
+    subprocess.run(
+        ["openssl", "req", "-x509", "-newkey", "ec", "-pkeyopt", "ec_paramgen_curve:prime256v1",
+         "-nodes", "-days", "30", "-subj", f"/CN={host}",
+         "-addext", f"subjectAltName=DNS:{host},DNS:localhost,IP:127.0.0.1,IP:10.0.2.2",
+         "-keyout", KEY, "-out", CERT],
+        check=True,
+    )
+
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"   # keep-alive, so one connection serves every request
+    rtt = 0.0
+
+    def setup(self):
+        super().setup()
+        self.requests_served = 0
+        self.opened = time.perf_counter()
+
+    def finish(self):
+        print(f"[conn {self.client_address[1]}] closed after "
+              f"{self.requests_served} request(s), {time.perf_counter() - self.opened:.1f}s")
+        super().finish()
+
+    def do_POST(self):
+        time.sleep(self.rtt)
+        length = int(self.headers.get("Content-Length", 0))
+        body = json.loads(self.rfile.read(length) or b"{}")
+        self.requests_served += 1
+
+        if self.path.endswith("/transactions/online"):
+            reply = {"tx_id": str(uuid.uuid4()), "status": "completed"}
+        elif self.path.endswith("/transactions/offline/sync"):
+            reply = {"accepted": [t["tx_id"] for t in body.get("transactions", [])], "rejected": []}
+        elif self.path.endswith("/transactions/verify-id"):
+            reply = {"match": True}
+        else:
+            self.send_error(404)
+            return
+
+        data = json.dumps(reply).encode()
+        self.send_response(200)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(data)))
+        self.end_headers()
+        self.wfile.write(data)
+        print(f"[conn {self.client_address[1]}] #{self.requests_served} {self.path}")
+
+
+class StandinServer(ThreadingHTTPServer):
+    rtt = 0.0
+
+    def get_request(self):
+        sock, addr = self.socket.accept()
+        time.sleep(self.rtt)                        # TCP handshake
+        start = time.perf_counter()
+        tls = self.context.wrap_socket(sock, server_side=True)
+        elapsed_ms = (time.perf_counter() - start) * 1000
+        resumed = tls.session_reused
+        time.sleep(self.rtt if resumed else 2 * self.rtt)
+        print(f"[conn {addr[1]}] TLS {tls.version()} {'RESUMED' if resumed else 'full'} handshake, "
+              f"{elapsed_ms:.1f} ms CPU/loopback + {(1 if resumed else 2) * self.rtt * 1000:.0f} ms simulated")
+        return tls, addr
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--host", default="0.0.0.0")
+    parser.add_argument("--port", type=int, default=8443)
+    parser.add_argument("--cert-host", default="localhost")
+    parser.add_argument("--rtt-ms", type=float, default=0.0, help="simulated network round-trip time")
+    args = parser.parse_args()
+
+    ensure_cert(args.cert_host)
+    context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+    context.load_cert_chain(CERT, KEY)
+    context.set_alpn_protocols(["http/1.1"])
+
+    Handler.rtt = args.rtt_ms / 1000.0
+    server = StandinServer((args.host, args.port), Handler)
+    server.context = context
+    server.rtt = Handler.rtt
+    print(f"FastPay TLS stand-in on https://{args.host}:{args.port} (rtt {args.rtt_ms} ms)")
+    server.serve_forever()
+
+
+if __name__ == "__main__":
+    main()
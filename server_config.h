@@ -26,6 +26,9 @@ namespace ServerConfig {
     const QString PRODUCTION_SERVER = "https://trinity-mlg4.onrender.com";
     
     // Automatic selection based on build type
+    // Offline transactions uploaded per /api/v1/transactions/offline/sync request
+    const int OFFLINE_SYNC_BATCH_SIZE = 50;
+
     #ifdef QT_DEBUG
         const QString CURRENT_SERVER = LOCAL_SERVER;
     #else
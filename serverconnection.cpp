@@ -0,0 +1,120 @@
+#include "serverconnection.h"
+#include <QDataStream>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QLoggingCategory>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QSaveFile>
+#include <QSslCertificate>
+#include <QStandardPaths>
+#include <QUrl>
+
+// Per-request timings; off unless enabled with QT_LOGGING_RULES="fastpay.network.debug=true"
+Q_LOGGING_CATEGORY(lcNetwork, "fastpay.network", QtWarningMsg)
+
+static QString sessionTicketPath()
+{
+    QString base = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(base);
+    return base + "/tls_session.bin";
+}
+
+ServerConnection::ServerConnection(QObject *parent)
+    : QObject(parent)
+{
+    m_network = new QNetworkAccessManager(this);
+
+    m_sslConfig = QSslConfiguration::defaultConfiguration();
+    m_sslConfig.setAllowedNextProtocols({ QSslConfiguration::ALPNProtocolHTTP2,
+                                          QSslConfiguration::NextProtocolHttp1_1 });
+    // Keep the session (and its ticket) so it can be resumed with an abbreviated handshake
+    m_sslConfig.setSslOption(QSsl::SslOptionDisableSessionPersistence, false);
+#ifdef QT_DEBUG
+    // Lets debug builds trust a local stand-in server (see server/tls_standin.py)
+    const QString extraCa = qEnvironmentVariable("FASTPAY_CA_CERT");
+    if (!extraCa.isEmpty())
+        m_sslConfig.addCaCertificates(QSslCertificate::fromPath(extraCa));
+#endif
+    loadSessionTicket();
+}
+
+void ServerConnection::setBaseUrl(const QString &baseUrl)
+{
+    if (baseUrl == m_baseUrl) return;
+    m_baseUrl = baseUrl;
+    prewarm();
+}
+
+void ServerConnection::loadSessionTicket()
+{
+    QFile f(sessionTicketPath());
+    if (!f.open(QIODevice::ReadOnly)) return;
+    QDataStream ds(&f);
+    ds.setVersion(QDataStream::Qt_6_0);
+    QString host;
+    QByteArray ticket;
+    ds >> host >> ticket;
+    if (ds.status() != QDataStream::Ok || ticket.isEmpty()) return;
+    m_ticketHost = host;
+    m_sslConfig.setSessionTicket(ticket);
+}
+
+void ServerConnection::rememberSession(QNetworkReply *reply)
+{
+    const QString host = reply->url().host();
+    const QByteArray ticket = reply->sslConfiguration().sessionTicket();
+    if (ticket.isEmpty() || (ticket == m_sslConfig.sessionTicket() && host == m_ticketHost))
+        return;
+    m_ticketHost = host;
+    m_sslConfig.setSessionTicket(ticket);
+
+    // The ticket resumes the session without a full handshake, so only this user may read it
+    QSaveFile f(sessionTicketPath());
+    if (!f.open(QIODevice::WriteOnly)) return;
+    if (!f.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner)) {
+        f.cancelWriting();
+        return;
+    }
+    QDataStream ds(&f);
+    ds.setVersion(QDataStream::Qt_6_0);
+    ds << host << ticket;
+    f.commit();
+}
+
+void ServerConnection::prewarm()
+{
+    const QUrl url(m_baseUrl);
+    if (!url.isValid() || url.host().isEmpty()) return;
+    if (url.scheme() == QLatin1String("https")) {
+        // A ticket issued by another host would only cost a failed resumption attempt
+        if (url.host() != m_ticketHost)
+            m_sslConfig.setSessionTicket(QByteArray());
+        m_network->connectToHostEncrypted(url.host(), quint16(url.port(443)), m_sslConfig);
+    } else {
+        m_network->connectToHost(url.host(), quint16(url.port(80)));
+    }
+}
+
+QNetworkReply *ServerConnection::postJson(const QString &path, const QByteArray &json)
+{
+    QNetworkRequest req(QUrl(m_baseUrl + path));
+    req.setHeader(QNetworkRequest::ContentTypeHeader, QStringLiteral("application/json"));
+    req.setHeader(QNetworkRequest::ContentLengthHeader, json.size());
+    req.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+    if (req.url().scheme() == QLatin1String("https"))
+        req.setSslConfiguration(m_sslConfig);
+
+    QElapsedTimer timer;
+    timer.start();
+    QNetworkReply *reply = m_network->post(req, json);
+    connect(reply, &QNetworkReply::finished, this, [this, reply, timer]() {
+        qCDebug(lcNetwork) << "POST" << reply->url().path() << "took" << timer.elapsed() << "ms"
+                 << (reply->attribute(QNetworkRequest::Http2WasUsedAttribute).toBool() ? "(HTTP/2)" : "(HTTP/1.1)");
+        if (reply->error() == QNetworkReply::NoError && reply->url().scheme() == QLatin1String("https"))
+            rememberSession(reply);
+    });
+    return reply;
+}
@@ -0,0 +1,40 @@
+#ifndef SERVERCONNECTION_H
+#define SERVERCONNECTION_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QString>
+#include <QSslConfiguration>
+
+class QNetworkAccessManager;
+class QNetworkReply;
+
+// Shared HTTP(S) channel to the FastPay server. Opens the connection ahead of the first
+// request, resumes TLS sessions from tickets persisted across launches, and offers HTTP/2
+// via ALPN so concurrent requests multiplex over the single warmed-up connection.
+class ServerConnection : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ServerConnection(QObject *parent = nullptr);
+
+    void setBaseUrl(const QString &baseUrl);
+    QString baseUrl() const { return m_baseUrl; }
+
+    // Starts DNS + TCP (+ TLS) to the server without sending a request
+    void prewarm();
+
+    QNetworkReply *postJson(const QString &path, const QByteArray &json);
+    QNetworkAccessManager *network() const { return m_network; }
+
+private:
+    void loadSessionTicket();
+    void rememberSession(QNetworkReply *reply);
+
+    QNetworkAccessManager *m_network = nullptr;
+    QSslConfiguration m_sslConfig;
+    QString m_baseUrl;
+    QString m_ticketHost;
+};
+
+#endif // SERVERCONNECTION_H
@@ -1,21 +1,78 @@
 #include "transactionengine.h"
 #include "transactionhistory.h"
-#include <QSettings>
+#include "offlineoutbox.h"
+#include "serverconnection.h"
+#include "Ultrasound.h"
+#include "PhoneHash.h"
+#include "KeyCache.h"
 #include <QStandardPaths>
 #include <QDir>
-#include <QCryptographicHash>
+#include <QFile>
+#include <QSaveFile>
 #include <QUuid>
-#include <QRegularExpression>
-#include <QNetworkAccessManager>
-#include <QNetworkRequest>
 #include <QNetworkReply>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QUrlQuery>
+#include <QDebug>
+#include <QPromise>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentRun>
+#include <algorithm>
+#include <array>
+#include <type_traits>
+#include <openssl/crypto.h>
 
-TransactionEngine::TransactionEngine(QObject *parent) : QObject(parent)
+static QString authPath()
+{
+    QString base = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(base);
+    return base + QStringLiteral("/auth.ini");
+}
+
+TransactionEngine::TransactionEngine(QObject *parent)
+    : QObject(parent)
+    , m_auth(authPath())
+{
+    loadDeviceKey();
+    m_connection = new ServerConnection(this);
+    m_outbox = new OfflineOutbox(m_connection, this);
+    connect(m_outbox, &OfflineOutbox::accountFrozen, this, &TransactionEngine::freezeAccountOnVerificationFailure);
+    m_localHistory.append(TransactionHistory::loadFrom(0, &m_historyOffset));
+
+    // Own pool so PIN hashing and signing never wait behind other QThreadPool::globalInstance() users
+    m_workers = new QThreadPool(this);
+    m_workers->setMaxThreadCount(qBound(1, QThread::idealThreadCount() / 2, 4));
+}
+
+TransactionEngine::~TransactionEngine()
 {
-    m_network = new QNetworkAccessManager(this);
+    // Queued jobs use this engine; let them drain before members are destroyed
+    m_workers->waitForDone();
+    m_deviceKey.reset();
+    KeyCache::instance().clearPrivateKeys();
+}
+
+// Bounded hand-off to the worker pool: past kMaxQueuedJobs the caller gets a canceled future
+template <typename Fn>
+auto TransactionEngine::runOnWorker(Fn &&fn) const
+{
+    using Result = std::invoke_result_t<std::decay_t<Fn>>;
+    if (m_queuedJobs.fetchAndAddOrdered(1) >= kMaxQueuedJobs) {
+        m_queuedJobs.fetchAndAddOrdered(-1);
+        QPromise<Result> rejected;
+        QFuture<Result> future = rejected.future();
+        rejected.start();
+        future.cancel();
+        rejected.finish();
+        return future;
+    }
+    return QtConcurrent::run(m_workers, [this, fn = std::forward<Fn>(fn)]() mutable {
+        Result result = fn();
+        m_queuedJobs.fetchAndAddOrdered(-1);
+        return result;
+    });
 }
 
 QString TransactionEngine::getTimestampNonce()
@@ -37,150 +94,387 @@ bool TransactionEngine::checkTransactionIdMatch(const QString &localTransactionI
     return true;
 }
 
-static QString normalizedPhone(const QString &phone)
+// Wire encoding: canonical text for the existing "amount" field plus the exact integer form
+static void insertAmount(QJsonObject &body, const Money &amount)
+{
+    body.insert(QStringLiteral("amount"), amount.toString());
+    body.insert(QStringLiteral("amount_minor"), amount.minorUnits());
+    body.insert(QStringLiteral("currency"), amount.currencyCode());
+}
+
+static ByteSpan bytesOf(const QByteArray &data)
 {
-    QString digits = phone.trimmed();
-    digits.remove(QRegularExpression(QStringLiteral("[^0-9]")));
-    return digits;
+    return { reinterpret_cast<const std::byte *>(data.constData()), size_t(data.size()) };
+}
+
+static MutableByteSpan writableBytesOf(QByteArray &data)
+{
+    return { reinterpret_cast<std::byte *>(data.data()), size_t(data.size()) };
+}
+
+static std::string_view viewOf(const QByteArray &data)
+{
+    return { data.constData(), size_t(data.size()) };
+}
+
+static std::u16string_view viewOf(const QString &s)
+{
+    return { reinterpret_cast<const char16_t *>(s.utf16()), size_t(s.size()) };
 }
 
 QByteArray TransactionEngine::publicKeyFromPhoneNumber(const QString &phoneNumber)
 {
-    QString norm = normalizedPhone(phoneNumber);
-    if (norm.isEmpty()) return QByteArray();
-    QByteArray hash = QCryptographicHash::hash(norm.toUtf8(), QCryptographicHash::Sha256);
-    return hash;
+    QByteArray key(qsizetype(PhoneHash::KEY_SIZE), Qt::Uninitialized);
+    if (!PhoneHash::hash(viewOf(phoneNumber), reinterpret_cast<unsigned char *>(key.data())))
+        return QByteArray();
+    return key;
 }
 
-QString TransactionEngine::publicKeyHexFromPhoneNumber(const QString &phoneNumber)
+QByteArray TransactionEngine::publicKeysFromPhoneNumbers(const QStringList &phoneNumbers, QList<bool> *found)
 {
-    return QString::fromUtf8(publicKeyFromPhoneNumber(phoneNumber).toHex());
+    std::vector<std::u16string_view> views;
+    views.reserve(size_t(phoneNumbers.size()));
+    for (const QString &phone : phoneNumbers)
+        views.push_back(viewOf(phone));
+    QByteArray keys(qsizetype(views.size() * PhoneHash::KEY_SIZE), Qt::Uninitialized);
+    const std::vector<uint64_t> bitmap =
+        PhoneHash::hashBatch(views.data(), views.size(), reinterpret_cast<unsigned char *>(keys.data()));
+    if (found) {
+        found->resize(phoneNumbers.size());
+        for (qsizetype i = 0; i < phoneNumbers.size(); ++i)
+            (*found)[i] = PhoneHash::hasKey(bitmap, size_t(i));
+    }
+    return keys;
 }
 
-static QString authPath()
+QString TransactionEngine::publicKeyHexFromPhoneNumber(const QString &phoneNumber)
 {
-    QString base = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
-    QDir().mkpath(base);
-    return base + QStringLiteral("/auth.ini");
+    return QString::fromUtf8(publicKeyFromPhoneNumber(phoneNumber).toHex());
 }
 
-bool TransactionEngine::setPin(const QString &pin)
+bool TransactionEngine::setPin(const SecureString &pin)
 {
-    QString p = pin.trimmed();
-    if (p.length() < 4 || p.length() > 6) return false;
-    QByteArray hash = QCryptographicHash::hash(p.toUtf8(), QCryptographicHash::Sha256);
-    QSettings s(authPath(), QSettings::IniFormat);
-    s.setValue(QStringLiteral("pin_hash"), hash.toHex());
-    s.sync();
-    return true;
+    return m_auth.setPin(pin);
 }
 
-bool TransactionEngine::verifyPin(const QString &pin) const
+bool TransactionEngine::verifyPin(const SecureString &pin) const
 {
-    QString p = pin.trimmed();
-    if (p.isEmpty()) return false;
-    QByteArray hash = QCryptographicHash::hash(p.toUtf8(), QCryptographicHash::Sha256);
-    QSettings s(authPath(), QSettings::IniFormat);
-    QString stored = s.value(QStringLiteral("pin_hash")).toString();
-    return QString::fromUtf8(hash.toHex()) == stored;
+    return m_auth.verify(pin);
 }
 
 bool TransactionEngine::hasPinSet() const
 {
-    QSettings s(authPath(), QSettings::IniFormat);
-    return s.contains(QStringLiteral("pin_hash"));
+    return m_auth.hasPin();
 }
 
-bool TransactionEngine::changePin(const QString &oldPin, const QString &newPin)
+bool TransactionEngine::changePin(const SecureString &oldPin, const SecureString &newPin)
 {
     if (!verifyPin(oldPin)) return false;
     return setPin(newPin);
 }
 
+QFuture<bool> TransactionEngine::setPinAsync(const SecureString &pin)
+{
+    return runOnWorker([this, pin]() { return setPin(pin); });
+}
+
+QFuture<bool> TransactionEngine::verifyPinAsync(const SecureString &pin) const
+{
+    return runOnWorker([this, pin]() { return verifyPin(pin); });
+}
+
 QByteArray TransactionEngine::buildOnlineEmitPayload(const QByteArray &headerIdentifier, const QByteArray &publicKeyPem)
 {
-    const int headerSize = 32;
-    const int keyMaxSize = 2208;
-    const int totalSize = headerSize + keyMaxSize;
+    std::array<std::byte, Ultrasound::HEADER_SIZE> header{};
+    const ByteSpan id = bytesOf(headerIdentifier);
+    std::copy_n(id.begin(), qMin(id.size(), header.size()), header.begin());
+    const ByteSpan key = bytesOf(publicKeyPem);
+    if (key.empty() || key.size() > Ultrasound::KEY_SIZE) return QByteArray();
+
+    // No padding to KEY_SIZE: the FEC header carries the length, and every byte costs air time
+    QByteArray payload(qsizetype(Ultrasound::HEADER_SIZE + key.size()), Qt::Uninitialized);
+    Ultrasound::buildFrame(header, key, writableBytesOf(payload));
+    return payload;
+}
 
-    QByteArray header = headerIdentifier.left(headerSize);
-    if (header.size() < headerSize)
-        header.append(QByteArray(headerSize - header.size(), 0));
+QByteArray TransactionEngine::extractKeyFromFrame(const QByteArray &frame, const QByteArray &header)
+{
+    // The demodulator syncs on the chirp preamble, so the header sits at the start of the frame
+    // rather than somewhere to be searched for. The frame carries the key's exact length, and the
+    // key may be binary (a phone hash or raw X25519), so nothing is trimmed.
+    const ByteSpan found = Ultrasound::keyInFrame(bytesOf(frame), bytesOf(header));
+    if (found.empty()) return QByteArray();
+    return QByteArray(reinterpret_cast<const char *>(found.data()), qsizetype(found.size()));
+}
+
+void TransactionEngine::submitOnlineTransaction(const QString &senderUpiId, const Money &amount,
+                                                const QByteArray &receiverPublicKeyPem, const SecureString &pin)
+{
+    Q_UNUSED(senderUpiId);
+    Q_UNUSED(receiverPublicKeyPem);
+    verifyPinAsync(pin).then(this, [this, amount](bool ok) {
+        if (!ok) {
+            emit onlineTransactionFailed(tr("Wrong UPI PIN. Transaction not approved."));
+            return;
+        }
+        QString txId = generateTransactionId();
 
-    QByteArray key = publicKeyPem.left(keyMaxSize);
-    if (key.size() < keyMaxSize)
-        key.append(QByteArray(keyMaxSize - key.size(), 0));
+        TransactionRecord rec;
+        rec.id = txId;
+        rec.type = "online";
+        rec.role = "sender";
+        rec.peerId = "receiver@fastpay";
+        rec.amount = amount;
+        rec.nonce = getTimestampNonce();
+        rec.status = "completed";
+        rec.createdAt = QDateTime::currentDateTime();
+        addToLocalHistory(rec);
+        emit onlineTransactionCompleted(txId);
+    }).onCanceled(this, [this]() {
+        emit onlineTransactionFailed(tr("Too many operations in progress. Try again."));
+    });
+}
 
-    return header + key;
+QString TransactionEngine::offlineMessage(const QString &senderId, const QString &receiverId,
+                                         const Money &amount, const QString &nonce)
+{
+    return senderId + QLatin1Char('|') + receiverId + QLatin1Char('|') + amount.toString()
+           + QLatin1Char('|') + nonce;
 }
 
-QByteArray TransactionEngine::extractKeyFromMicBuffer(const QByteArray &micBuffer2x, const QByteArray &header)
+// One key file per scheme, so changing OfflineSignatureScheme starts a key for the new scheme
+// and keeps the old one for checking what it signed
+static QString deviceKeyPath(DigitalSignature::SchemeId scheme)
 {
-    int idx = micBuffer2x.indexOf(header);
-    if (idx < 0) return QByteArray();
-    int keyStart = idx + header.size();
-    const int keyMaxSize = 2208;
-    if (keyStart + keyMaxSize > micBuffer2x.size()) return QByteArray();
-    QByteArray key = micBuffer2x.mid(keyStart, keyMaxSize);
-    int endMark = key.indexOf("-----END PUBLIC KEY-----");
-    if (endMark >= 0)
-        key = key.left(endMark + 24);
-    return key.trimmed();
+    QString base = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(base);
+    return base + QStringLiteral("/device_key.") + QLatin1String(DigitalSignature::schemeName(scheme))
+           + QStringLiteral(".pem");
 }
 
-bool TransactionEngine::submitOnlineTransaction(const QString &senderUpiId, const QString &amount,
-                                                const QByteArray &receiverPublicKeyPem, const QString &pin)
+static bool readDeviceKey(const QString &path, SecureString &privPem)
 {
-    Q_UNUSED(receiverPublicKeyPem);
-    if (!verifyPin(pin)) {
-        emit onlineTransactionFailed(tr("Wrong UPI PIN. Transaction not approved."));
-        return false;
-    }
-    QString nonce = getTimestampNonce();
-    QString txId = generateTransactionId();
-
-    TransactionRecord rec;
-    rec.id = txId;
-    rec.type = "online";
-    rec.role = "sender";
-    rec.peerId = "receiver@fastpay";
-    rec.amount = amount;
-    rec.nonce = nonce;
-    rec.status = "completed";
-    rec.createdAt = QDateTime::currentDateTime();
-    addToLocalHistory(rec);
-    emit onlineTransactionCompleted(txId);
+    QFile in(path);
+    if (!in.open(QIODevice::ReadOnly)) return false;
+    QByteArray pem = in.readAll();
+    privPem.assign(pem.constData(), size_t(pem.size()));
+    OPENSSL_cleanse(pem.data(), size_t(pem.size()));
     return true;
 }
 
+// Keys from before the file name carried the scheme: moved to the name for whichever scheme
+// the key turns out to be
+static void migrateUntaggedDeviceKey()
+{
+    const QString legacy = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)
+                           + QStringLiteral("/device_key.pem");
+    SecureString privPem;
+    if (!QFile::exists(legacy) || !readDeviceKey(legacy, privPem)) return;
+    DigitalSignature::SchemeId scheme;
+    if (!DigitalSignature::schemeOfPrivateKey(privPem, scheme)) {
+        qWarning() << "Device key" << legacy << "is of no known scheme; leaving it in place";
+        return;
+    }
+    const QString tagged = deviceKeyPath(scheme);
+    if (!QFile::exists(tagged) && !QFile::rename(legacy, tagged))
+        qWarning() << "Could not move device key" << legacy << "to" << tagged;
+}
+
+void TransactionEngine::loadDeviceKey()
+{
+    migrateUntaggedDeviceKey();
+    const QString path = deviceKeyPath(OfflineSignatureScheme::id);
+    SecureString privPem;
+    QFile in(path);
+    const bool exists = in.exists();
+    if (exists) {
+        // The key is the device's identity: never replace one we merely failed to read
+        if (!in.open(QIODevice::ReadOnly)) {
+            qCritical() << "Cannot read device key" << path << in.errorString()
+                        << "- offline signing is unavailable";
+            return;
+        }
+        QByteArray pem = in.readAll();
+        in.close();
+        privPem.assign(pem.constData(), size_t(pem.size()));
+        OPENSSL_cleanse(pem.data(), size_t(pem.size()));
+    }
+    auto key = std::make_shared<const OfflineSignatureScheme::SigningKey>(privPem);
+    if (!key->isValid()) {
+        DigitalSignature::SchemeId found;
+        if (exists && DigitalSignature::schemeOfPrivateKey(privPem, found)) {
+            // A good key, just not for this scheme: not corruption, and not to be replaced
+            qCritical() << "Device key" << path << "is a" << DigitalSignature::schemeName(found)
+                        << "key, expected" << OfflineSignatureScheme::name()
+                        << "- offline signing is unavailable";
+            return;
+        }
+        if (exists) {
+            // Corrupt: keep it for recovery and start a new identity
+            const QString aside = path + QStringLiteral(".corrupt-")
+                                  + QDateTime::currentDateTimeUtc().toString(QStringLiteral("yyyyMMddHHmmss"));
+            if (!QFile::rename(path, aside)) {
+                qCritical() << "Device key" << path << "is corrupt and could not be moved aside"
+                            << "- offline signing is unavailable";
+                return;
+            }
+            qCritical() << "Device key" << path << "is corrupt; moved to" << aside
+                        << "and generating a new device identity";
+        }
+        std::string pubPem;
+        OfflineSignatureScheme::generateKeyPair(pubPem, privPem);
+        key = std::make_shared<const OfflineSignatureScheme::SigningKey>(privPem);
+        QSaveFile out(path);
+        if (key->isValid() && out.open(QIODevice::WriteOnly)) {
+            out.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner);
+            out.write(privPem.data(), qint64(privPem.size()));
+            if (!out.commit())
+                qWarning() << "Could not save the device key to" << path;
+        }
+    }
+    if (!key->isValid()) {
+        qWarning() << "No device signing key; offline signing is unavailable";
+        return;
+    }
+    m_deviceKey = key;
+    m_devicePublicKeyPem = QByteArray::fromStdString(key->publicKeyPem());
+    m_deviceVerifyingKey = std::make_shared<const OfflineSignatureScheme::VerifyingKey>(viewOf(m_devicePublicKeyPem));
+}
+
+// Parsing goes through KeyCache, so repeated signing/verification with one key skips PEM
+// decoding without the engine holding key material of its own
+template <typename Key>
+static std::shared_ptr<const Key> parsedKey(const QByteArray &pem)
+{
+    auto key = std::make_shared<const Key>(viewOf(pem));
+    return key->isValid() ? key : nullptr;
+}
+
+std::shared_ptr<const OfflineSignatureScheme::SigningKey> TransactionEngine::signingKey(const QByteArray &privateKeyPem) const
+{
+    if (privateKeyPem.isEmpty()) return m_deviceKey;
+    return parsedKey<OfflineSignatureScheme::SigningKey>(privateKeyPem);
+}
+
+std::shared_ptr<const OfflineSignatureScheme::VerifyingKey> TransactionEngine::verifyingKey(const QByteArray &publicKeyPem) const
+{
+    if (publicKeyPem.isEmpty()) return m_deviceVerifyingKey;
+    return parsedKey<OfflineSignatureScheme::VerifyingKey>(publicKeyPem);
+}
+
+static QByteArray signWith(const OfflineSignatureScheme::SigningKey *key, const QString &message)
+{
+    if (!key) return QByteArray();
+    const QByteArray utf8 = message.toUtf8();
+    std::array<std::byte, OfflineSignatureScheme::maxSignatureSize> sig;
+    const size_t size = key->sign(bytesOf(utf8), sig);
+    if (size == 0 || size > sig.size()) return QByteArray();
+    return QByteArray(reinterpret_cast<const char *>(sig.data()), qsizetype(size));
+}
+
 QByteArray TransactionEngine::signOfflineTransaction(const QString &senderId, const QString &receiverId,
-                                                     const QString &amount, const QString &nonce,
+                                                     const Money &amount, const QString &nonce,
                                                      const QByteArray &senderPrivateKeyPem)
 {
-    Q_UNUSED(senderPrivateKeyPem);
-    QString message = senderId + "|" + receiverId + "|" + amount + "|" + nonce;
-    return QCryptographicHash::hash(message.toUtf8(), QCryptographicHash::Sha256);
+    return signWith(signingKey(senderPrivateKeyPem).get(), offlineMessage(senderId, receiverId, amount, nonce));
+}
+
+template <typename Scheme>
+static bool verifyWithScheme(const QByteArray &message, const QByteArray &signature, const QByteArray &publicKeyPem)
+{
+    const typename Scheme::VerifyingKey key(viewOf(publicKeyPem));
+    return key.isValid() && key.verify(bytesOf(message), bytesOf(signature));
+}
+
+template <typename Scheme>
+static QByteArray publicKeyOfDeviceKey(const QString &path)
+{
+    SecureString privPem;
+    if (!readDeviceKey(path, privPem)) return QByteArray();
+    const typename Scheme::SigningKey key(privPem);
+    return key.isValid() ? QByteArray::fromStdString(key.publicKeyPem()) : QByteArray();
+}
+
+QByteArray TransactionEngine::devicePublicKeyPemFor(DigitalSignature::SchemeId scheme) const
+{
+    using namespace DigitalSignature;
+    if (scheme == OfflineSignatureScheme::id) return m_devicePublicKeyPem;
+    switch (scheme) {
+    case SchemeId::P256:    return publicKeyOfDeviceKey<SignatureScheme<P256>>(deviceKeyPath(scheme));
+    case SchemeId::Ed25519: return publicKeyOfDeviceKey<SignatureScheme<Ed25519>>(deviceKeyPath(scheme));
+    }
+    return QByteArray();
 }
 
 bool TransactionEngine::verifyOfflineTransaction(const QString &message, const QByteArray &signature,
-                                                 const QByteArray &senderPublicKeyPem)
+                                                 const QByteArray &senderPublicKeyPem,
+                                                 DigitalSignature::SchemeId scheme)
 {
-    Q_UNUSED(senderPublicKeyPem);
-    QByteArray expected = QCryptographicHash::hash(message.toUtf8(), QCryptographicHash::Sha256);
-    return expected == signature;
+    using namespace DigitalSignature;
+    if (signature.isEmpty()) return false;
+    if (scheme == OfflineSignatureScheme::id) {
+        auto key = verifyingKey(senderPublicKeyPem);
+        return key && key->verify(bytesOf(message.toUtf8()), bytesOf(signature));
+    }
+    // Signed under another scheme (before a switch, or by a peer still on it)
+    const QByteArray pem = senderPublicKeyPem.isEmpty() ? devicePublicKeyPemFor(scheme) : senderPublicKeyPem;
+    if (pem.isEmpty()) return false;
+    switch (scheme) {
+    case SchemeId::P256:    return verifyWithScheme<SignatureScheme<P256>>(message.toUtf8(), signature, pem);
+    case SchemeId::Ed25519: return verifyWithScheme<SignatureScheme<Ed25519>>(message.toUtf8(), signature, pem);
+    }
+    return false;
 }
 
 QByteArray TransactionEngine::signReceipt(const QString &originalMessage, const QByteArray &receiverPrivateKeyPem)
 {
-    Q_UNUSED(receiverPrivateKeyPem);
-    QString receiptMessage = originalMessage + "|RECEIPT";
-    return QCryptographicHash::hash(receiptMessage.toUtf8(), QCryptographicHash::Sha256);
+    return signWith(signingKey(receiverPrivateKeyPem).get(), originalMessage + "|RECEIPT");
+}
+
+QFuture<QByteArray> TransactionEngine::signOfflineTransactionAsync(const QString &senderId, const QString &receiverId,
+                                                                  const Money &amount, const QString &nonce,
+                                                                  const QByteArray &senderPrivateKeyPem)
+{
+    return runOnWorker([this, senderId, receiverId, amount, nonce, senderPrivateKeyPem]() {
+        return signOfflineTransaction(senderId, receiverId, amount, nonce, senderPrivateKeyPem);
+    });
+}
+
+QFuture<bool> TransactionEngine::verifyOfflineTransactionAsync(const QString &message, const QByteArray &signature,
+                                                              const QByteArray &senderPublicKeyPem,
+                                                              DigitalSignature::SchemeId scheme)
+{
+    return runOnWorker([this, message, signature, senderPublicKeyPem, scheme]() {
+        return verifyOfflineTransaction(message, signature, senderPublicKeyPem, scheme);
+    });
+}
+
+QFuture<QByteArray> TransactionEngine::signReceiptAsync(const QString &originalMessage,
+                                                        const QByteArray &receiverPrivateKeyPem)
+{
+    return runOnWorker([this, originalMessage, receiverPrivateKeyPem]() {
+        return signReceipt(originalMessage, receiverPrivateKeyPem);
+    });
 }
 
-void TransactionEngine::submitOfflineWhenOnline(const TransactionRecord &record)
+void TransactionEngine::submitOfflineWhenOnline(const TransactionRecord &record, const QString &localUserId,
+                                                const QByteArray &senderSignature, const QByteArray &receiptSignature)
 {
     addToLocalHistory(record);
-    emit historyUpdated();
+
+    OfflineSyncItem item;
+    item.userId = localUserId;
+    item.txId = record.id;
+    const bool isSender = record.role == QLatin1String("sender");
+    item.senderId = isSender ? localUserId : record.peerId;
+    item.receiverId = isSender ? record.peerId : localUserId;
+    item.amount = record.amount;
+    item.nonce = record.nonce;
+    item.senderSignature = senderSignature;
+    item.receiptSignature = receiptSignature;
+    item.signatureScheme = quint8(OfflineSignatureScheme::id);
+    item.createdAt = record.createdAt;
+    m_outbox->enqueue(item);
 }
 
 void TransactionEngine::freezeAccountOnVerificationFailure()
@@ -189,15 +483,29 @@ void TransactionEngine::freezeAccountOnVerificationFailure()
     emit accountFrozen();
 }
 
-QList<TransactionRecord> TransactionEngine::getLocalHistory() const
+void TransactionEngine::addToLocalHistory(const TransactionRecord &record)
 {
-    return TransactionHistory::load();
+    // Pick up anything written to the journal behind our back before appending
+    if (TransactionHistory::endOffset() != m_historyOffset)
+        reloadLocalHistory();
+    qint64 end = TransactionHistory::append(record);
+    if (end < 0) return;
+    m_historyOffset = end;
+    m_localHistory.append(record);
+    emit historyUpdated({ record });
 }
 
-void TransactionEngine::addToLocalHistory(const TransactionRecord &record)
+void TransactionEngine::reloadLocalHistory()
 {
-    TransactionHistory::append(record);
-    emit historyUpdated();
+    if (TransactionHistory::endOffset() < m_historyOffset) {
+        // History was cleared: start over
+        m_localHistory.clear();
+        m_historyOffset = 0;
+    }
+    QList<TransactionRecord> added = TransactionHistory::loadFrom(m_historyOffset, &m_historyOffset);
+    if (added.isEmpty()) return;
+    m_localHistory.append(added);
+    emit historyUpdated(added);
 }
 
 void TransactionEngine::setServerBaseUrl(const QString &baseUrl)
@@ -205,34 +513,45 @@ void TransactionEngine::setServerBaseUrl(const QString &baseUrl)
     m_serverBaseUrl = baseUrl.trimmed();
     if (m_serverBaseUrl.endsWith(QLatin1Char('/')))
         m_serverBaseUrl.chop(1);
+    // Warm up DNS/TCP/TLS now so the first payment costs a single round trip
+    m_connection->setBaseUrl(m_serverBaseUrl);
+    m_outbox->flush();
 }
 
 void TransactionEngine::submitOnlineTransactionToServer(const QString &senderId, const QString &receiverId,
-                                                       const QString &amount, const QString &pin)
+                                                       const Money &amount, const SecureString &pin)
 {
-    if (!verifyPin(pin)) {
-        emit onlineTransactionFailed(tr("Wrong UPI PIN. Transaction not approved."));
-        return;
-    }
     if (m_serverBaseUrl.isEmpty()) {
         emit onlineTransactionFailed(tr("Server URL not set. Set server base URL or use offline submit."));
         return;
     }
     QString nonce = getTimestampNonce();
-    QJsonObject body;
-    body.insert(QStringLiteral("sender_id"), senderId);
-    body.insert(QStringLiteral("receiver_id"), receiverId);
-    body.insert(QStringLiteral("amount"), amount);
-    body.insert(QStringLiteral("nonce"), nonce);
-    QByteArray json = QJsonDocument(body).toJson(QJsonDocument::Compact);
+    // PIN check and request body are built on the worker pool; only the send happens here
+    runOnWorker([this, senderId, receiverId, amount, nonce, pin]() {
+        if (!verifyPin(pin)) return QByteArray();
+        QJsonObject body;
+        body.insert(QStringLiteral("sender_id"), senderId);
+        body.insert(QStringLiteral("receiver_id"), receiverId);
+        insertAmount(body, amount);
+        body.insert(QStringLiteral("nonce"), nonce);
+        return QJsonDocument(body).toJson(QJsonDocument::Compact);
+    }).then(this, [this, receiverId, amount, nonce](const QByteArray &json) {
+        if (json.isEmpty()) {
+            emit onlineTransactionFailed(tr("Wrong UPI PIN. Transaction not approved."));
+            return;
+        }
+        postOnlineTransaction(json, receiverId, amount, nonce);
+    }).onCanceled(this, [this]() {
+        emit onlineTransactionFailed(tr("Too many operations in progress. Try again."));
+    });
+}
 
-    QUrl url(m_serverBaseUrl + QStringLiteral("/api/v1/transactions/online"));
-    QNetworkRequest req(url);
-    req.setHeader(QNetworkRequest::ContentTypeHeader, QStringLiteral("application/json"));
-    req.setHeader(QNetworkRequest::ContentLengthHeader, json.size());
-    QNetworkReply *reply = m_network->post(req, json);
+void TransactionEngine::postOnlineTransaction(const QByteArray &json, const QString &receiverId,
+                                              const Money &amount, const QString &nonce)
+{
+    QNetworkReply *reply = m_connection->postJson(QStringLiteral("/api/v1/transactions/online"), json);
 
-    connect(reply, &QNetworkReply::finished, this, [this, reply, senderId, receiverId, amount, nonce]() {
+    connect(reply, &QNetworkReply::finished, this, [this, reply, receiverId, amount, nonce]() {
         reply->deleteLater();
         if (reply->error() != QNetworkReply::NoError) {
             if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 403) {
@@ -272,26 +591,23 @@ void TransactionEngine::submitOnlineTransactionToServer(const QString &senderId,
 
 void TransactionEngine::verifyTransactionIdWithServer(const QString &userId, const QString &transactionId,
                                                      const QString &senderId, const QString &receiverId,
-                                                     const QString &nonce, const QString &amount)
+                                                     const QString &nonce, const Money &amount)
 {
     if (m_serverBaseUrl.isEmpty()) {
         return;
     }
+    // Six small fields: built here rather than on a worker, whose bounded queue may refuse the
+    // job and would then skip the check (and the 403 freeze) altogether
     QJsonObject body;
     body.insert(QStringLiteral("user_id"), userId);
     body.insert(QStringLiteral("transaction_id"), transactionId);
     body.insert(QStringLiteral("sender_id"), senderId);
     body.insert(QStringLiteral("receiver_id"), receiverId);
     body.insert(QStringLiteral("nonce"), nonce);
-    body.insert(QStringLiteral("amount"), amount);
-    QByteArray json = QJsonDocument(body).toJson(QJsonDocument::Compact);
-
-    QUrl url(m_serverBaseUrl + QStringLiteral("/api/v1/transactions/verify-id"));
-    QNetworkRequest req(url);
-    req.setHeader(QNetworkRequest::ContentTypeHeader, QStringLiteral("application/json"));
-    req.setHeader(QNetworkRequest::ContentLengthHeader, json.size());
-    QNetworkReply *reply = m_network->post(req, json);
+    insertAmount(body, amount);
+    const QByteArray json = QJsonDocument(body).toJson(QJsonDocument::Compact);
 
+    QNetworkReply *reply = m_connection->postJson(QStringLiteral("/api/v1/transactions/verify-id"), json);
     connect(reply, &QNetworkReply::finished, this, [this, reply]() {
         reply->deleteLater();
         if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 403) {
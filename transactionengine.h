@@ -3,27 +3,30 @@
 
 #include <QObject>
 #include <QString>
+#include <QStringList>
 #include <QByteArray>
 #include <QDateTime>
+#include <QFuture>
+#include <QAtomicInt>
+#include <memory>
+#include "transactionrecord.h"
+#include "historystore.h"
+#include "authstate.h"
+#include "SignatureScheme.h"
 
-class QNetworkAccessManager;
-
-struct TransactionRecord {
-    QString id;
-    QString type;       // "online" | "offline"
-    QString role;       // "sender" | "receiver"
-    QString peerId;
-    QString amount;
-    QString nonce;      // timestamp (date + time)
-    QString status;     // "pending" | "completed" | "failed" | "frozen"
-    QDateTime createdAt;
-};
+// Algorithm for offline transfer signatures and receipts; recorded with every synced transfer
+using OfflineSignatureScheme = DigitalSignature::SignatureScheme<DigitalSignature::P256>;
+
+class ServerConnection;
+class OfflineOutbox;
+class QThreadPool;
 
 class TransactionEngine : public QObject
 {
     Q_OBJECT
 public:
     explicit TransactionEngine(QObject *parent = nullptr);
+    ~TransactionEngine();
 
     // Nonce = timestamp (date + time) for all transactions
     static QString getTimestampNonce();
@@ -31,12 +34,22 @@ public:
     // --- Phone number → public key (hash of normalized phone) ---
     static QByteArray publicKeyFromPhoneNumber(const QString &phoneNumber);
     static QString publicKeyHexFromPhoneNumber(const QString &phoneNumber);
+    // Contact-book import: the same keys back to back, 32 bytes per number (all zero, and
+    // found[i] false, where a number has no digits). Hashing is spread over all cores.
+    static QByteArray publicKeysFromPhoneNumbers(const QStringList &phoneNumbers, QList<bool> *found = nullptr);
 
     // --- UPI-style PIN: set once, then verify to approve/verify transactions ---
-    bool setPin(const QString &pin);
-    bool verifyPin(const QString &pin) const;
+    // PINs stay in SecureString (secure arena, wiped on release) from PinDialog to AuthState
+    bool setPin(const SecureString &pin);
+    bool verifyPin(const SecureString &pin) const;
     bool hasPinSet() const;
-    bool changePin(const QString &oldPin, const QString &newPin);
+    bool changePin(const SecureString &oldPin, const SecureString &newPin);
+
+    // --- Async variants: run on the engine's worker pool; continue with .then(context, ...) ---
+    // When kMaxQueuedJobs are already pending the returned future is canceled instead of queued.
+    static constexpr int kMaxQueuedJobs = 8;
+    QFuture<bool> setPinAsync(const SecureString &pin);
+    QFuture<bool> verifyPinAsync(const SecureString &pin) const;
 
     // --- Transaction ID: generate (client) and verify match; on mismatch report account freezed ---
     static QString generateTransactionId();
@@ -44,30 +57,51 @@ public:
     void setServerBaseUrl(const QString &baseUrl);
     QString serverBaseUrl() const { return m_serverBaseUrl; }
     void submitOnlineTransactionToServer(const QString &senderId, const QString &receiverId,
-                                         const QString &amount, const QString &pin);
+                                         const Money &amount, const SecureString &pin);
     void verifyTransactionIdWithServer(const QString &userId, const QString &transactionId,
                                        const QString &senderId, const QString &receiverId,
-                                       const QString &nonce, const QString &amount);
+                                       const QString &nonce, const Money &amount);
 
-    // --- Online: receiver emits ultrasound (header + public key); sender captures 2x, extracts key, pays with PIN ---
+    // --- Online: receiver emits ultrasound (header + public key); sender decodes the frame, extracts key, pays with PIN ---
     QByteArray buildOnlineEmitPayload(const QByteArray &headerIdentifier, const QByteArray &publicKeyPem);
-    QByteArray extractKeyFromMicBuffer(const QByteArray &micBuffer2x, const QByteArray &header);
-    bool submitOnlineTransaction(const QString &senderUpiId, const QString &amount,
-                                 const QByteArray &receiverPublicKeyPem, const QString &pin);
+    QByteArray extractKeyFromFrame(const QByteArray &frame, const QByteArray &header);
+    // Outcome arrives via onlineTransactionCompleted / onlineTransactionFailed
+    void submitOnlineTransaction(const QString &senderUpiId, const Money &amount,
+                                 const QByteArray &receiverPublicKeyPem, const SecureString &pin);
 
     // --- Offline: cold wallet to cold wallet; sender signs, receiver verifies and sends receipt; sync when online ---
+    // Signed with OfflineSignatureScheme. An empty key PEM means this device's own key pair (created on first run).
+    QByteArray devicePublicKeyPem() const { return m_devicePublicKeyPem; }
+    // Canonical message signed for offline transfers: "senderId|receiverId|amount|nonce"
+    static QString offlineMessage(const QString &senderId, const QString &receiverId,
+                                  const Money &amount, const QString &nonce);
     QByteArray signOfflineTransaction(const QString &senderId, const QString &receiverId,
-                                      const QString &amount, const QString &nonce,
+                                      const Money &amount, const QString &nonce,
                                       const QByteArray &senderPrivateKeyPem);
+    // scheme is the one recorded with the signature; an empty key PEM then means this device's
+    // key pair for that scheme
     bool verifyOfflineTransaction(const QString &message, const QByteArray &signature,
-                                  const QByteArray &senderPublicKeyPem);
+                                  const QByteArray &senderPublicKeyPem,
+                                  DigitalSignature::SchemeId scheme = OfflineSignatureScheme::id);
     QByteArray signReceipt(const QString &originalMessage, const QByteArray &receiverPrivateKeyPem);
-    void submitOfflineWhenOnline(const TransactionRecord &record);
+    QFuture<QByteArray> signOfflineTransactionAsync(const QString &senderId, const QString &receiverId,
+                                                    const Money &amount, const QString &nonce,
+                                                    const QByteArray &senderPrivateKeyPem);
+    QFuture<bool> verifyOfflineTransactionAsync(const QString &message, const QByteArray &signature,
+                                                const QByteArray &senderPublicKeyPem,
+                                                DigitalSignature::SchemeId scheme = OfflineSignatureScheme::id);
+    QFuture<QByteArray> signReceiptAsync(const QString &originalMessage, const QByteArray &receiverPrivateKeyPem);
+    // Records the transfer locally and queues it (with both signatures) for batched server sync
+    void submitOfflineWhenOnline(const TransactionRecord &record, const QString &localUserId,
+                                 const QByteArray &senderSignature, const QByteArray &receiptSignature);
+    OfflineOutbox *offlineOutbox() const { return m_outbox; }
     void freezeAccountOnVerificationFailure();
 
-    // History (stored online and offline)
-    QList<TransactionRecord> getLocalHistory() const;
+    // History (stored online and offline). Loaded once; kept resident and updated in place.
+    const HistoryStore &localHistory() const { return m_localHistory; }
+    QList<TransactionRecord> getLocalHistory() const { return m_localHistory.toList(); }
     void addToLocalHistory(const TransactionRecord &record);
+    void reloadLocalHistory();
     bool isAccountFrozen() const { return m_accountFrozen; }
 
 signals:
@@ -76,13 +110,30 @@ signals:
     void offlineTransactionVerified(const QString &txId);
     void offlineVerificationFailed();
     void accountFrozen();
-    void historyUpdated();
+    void historyUpdated(const QList<TransactionRecord> &added);
 
 private:
+    template <typename Fn>
+    auto runOnWorker(Fn &&fn) const;
+    void postOnlineTransaction(const QByteArray &json, const QString &receiverId,
+                               const Money &amount, const QString &nonce);
+    void loadDeviceKey();
+    QByteArray devicePublicKeyPemFor(DigitalSignature::SchemeId scheme) const;
+    std::shared_ptr<const OfflineSignatureScheme::SigningKey> signingKey(const QByteArray &privateKeyPem) const;
+    std::shared_ptr<const OfflineSignatureScheme::VerifyingKey> verifyingKey(const QByteArray &publicKeyPem) const;
+
     bool m_accountFrozen = false;
-    QList<TransactionRecord> m_localHistory;
+    mutable AuthState m_auth;       // internally locked; verify() may rewrite a legacy entry
+    HistoryStore m_localHistory;
+    qint64 m_historyOffset = 0;     // journal offset just past the last record in m_localHistory
     QString m_serverBaseUrl;
-    QNetworkAccessManager *m_network = nullptr;
+    ServerConnection *m_connection = nullptr;
+    OfflineOutbox *m_outbox = nullptr;
+    QThreadPool *m_workers = nullptr;
+    std::shared_ptr<const OfflineSignatureScheme::SigningKey> m_deviceKey;
+    std::shared_ptr<const OfflineSignatureScheme::VerifyingKey> m_deviceVerifyingKey;
+    QByteArray m_devicePublicKeyPem;
+    mutable QAtomicInt m_queuedJobs;
 };
 
 #endif // TRANSACTIONENGINE_H
@@ -1,19 +1,88 @@
 #include "transactionhistory.h"
+#include "recordjournal.h"
 #include <QSettings>
 #include <QStandardPaths>
 #include <QDir>
+#include <QFile>
+#include <QDataStream>
+#include <QDebug>
 
-static QString historyPath()
+static constexpr quint8 kRecordVersionText = 1;    // amount stored as text
+static constexpr quint8 kRecordVersion = 2;        // amount stored as minor units + currency
+
+static QString dataDir()
 {
     QString base = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
     QDir().mkpath(base);
-    return base + "/transaction_history.ini";
+    return base;
 }
 
-QList<TransactionRecord> TransactionHistory::load()
+static QString legacyIniPath()
+{
+    return dataDir() + "/transaction_history.ini";
+}
+
+static QString journalPath()
+{
+    return dataDir() + "/transaction_history.journal";
+}
+
+static QByteArray encodeRecord(const TransactionRecord &r)
+{
+    QByteArray out;
+    QDataStream ds(&out, QIODevice::WriteOnly);
+    ds.setVersion(QDataStream::Qt_6_0);
+    // A legacy amount that never parsed keeps its text, in the old record layout
+    const bool rawAmount = !r.amount.isValid() && !r.amountText.isEmpty();
+    ds << (rawAmount ? kRecordVersionText : kRecordVersion)
+       << r.id.toUtf8() << r.type.toUtf8() << r.role.toUtf8() << r.peerId.toUtf8();
+    if (rawAmount)
+        ds << r.amountText.toUtf8();
+    else
+        ds << r.amount.minorUnits() << r.amount.currencyTag();
+    ds << r.nonce.toUtf8() << r.status.toUtf8()
+       << qint64(r.createdAt.isValid() ? r.createdAt.toMSecsSinceEpoch() : -1);
+    return out;
+}
+
+static bool decodeRecord(const QByteArray &payload, TransactionRecord &r)
+{
+    QDataStream ds(payload);
+    ds.setVersion(QDataStream::Qt_6_0);
+    quint8 version = 0;
+    ds >> version;
+    if (version != kRecordVersion && version != kRecordVersionText) return false;
+    QByteArray id, type, role, peerId, nonce, status;
+    qint64 createdAtMs = -1;
+    ds >> id >> type >> role >> peerId;
+    if (version == kRecordVersionText) {
+        QByteArray amountText;
+        ds >> amountText;
+        r.amount = Money::fromUtf8(amountText.constData(), amountText.size());
+        if (!r.amount.isValid())
+            r.amountText = QString::fromUtf8(amountText);
+    } else {
+        qint64 minor = 0;
+        quint32 currency = 0;
+        ds >> minor >> currency;
+        r.amount = Money::fromMinorUnits(minor, currency);
+    }
+    ds >> nonce >> status >> createdAtMs;
+    if (ds.status() != QDataStream::Ok) return false;
+    r.id = QString::fromUtf8(id);
+    r.type = QString::fromUtf8(type);
+    r.role = QString::fromUtf8(role);
+    r.peerId = QString::fromUtf8(peerId);
+    r.nonce = QString::fromUtf8(nonce);
+    r.status = QString::fromUtf8(status);
+    r.createdAt = createdAtMs >= 0 ? QDateTime::fromMSecsSinceEpoch(createdAtMs) : QDateTime();
+    return true;
+}
+
+static QList<TransactionRecord> loadLegacyIni(const QString &path)
 {
     QList<TransactionRecord> list;
-    QSettings s(historyPath(), QSettings::IniFormat);
+    QSettings s(path, QSettings::IniFormat);
     int size = s.beginReadArray("transactions");
     for (int i = 0; i < size; ++i) {
         s.setArrayIndex(i);
@@ -22,7 +91,10 @@ QList<TransactionRecord> TransactionHistory::load()
         r.type = s.value("type").toString();
         r.role = s.value("role").toString();
         r.peerId = s.value("peerId").toString();
-        r.amount = s.value("amount").toString();
+        const QString amountText = s.value("amount").toString();
+        r.amount = Money::fromString(amountText);
+        if (!r.amount.isValid())
+            r.amountText = amountText;
         r.nonce = s.value("nonce").toString();
         r.status = s.value("status").toString();
         r.createdAt = s.value("createdAt").toDateTime();
@@ -32,28 +104,77 @@ QList<TransactionRecord> TransactionHistory::load()
     return list;
 }
 
-void TransactionHistory::append(const TransactionRecord &record)
+// One-time import of the old QSettings store. The journal is built under a temporary
+// name and renamed into place, so a crash mid-migration simply reruns it next launch.
+static void migrateLegacyIni()
 {
-    QSettings s(historyPath(), QSettings::IniFormat);
-    int size = s.beginReadArray("transactions");
-    s.endArray();
-    s.beginWriteArray("transactions");
-    for (int i = 0; i < size; ++i)
-        s.setArrayIndex(i);
-    s.setArrayIndex(size);
-    s.setValue("id", record.id);
-    s.setValue("type", record.type);
-    s.setValue("role", record.role);
-    s.setValue("peerId", record.peerId);
-    s.setValue("amount", record.amount);
-    s.setValue("nonce", record.nonce);
-    s.setValue("status", record.status);
-    s.setValue("createdAt", record.createdAt);
-    s.endArray();
+    const QString iniPath = legacyIniPath();
+    if (!QFile::exists(iniPath) || QFile::exists(journalPath())) return;
+
+    const QList<TransactionRecord> legacy = loadLegacyIni(iniPath);
+    const QString tmpPath = journalPath() + ".tmp";
+    QFile::remove(tmpPath);
+    {
+        RecordJournal tmp(tmpPath);
+        if (!tmp.open()) return;
+        // One sync for the whole import rather than one per record: this runs at startup
+        QList<QByteArray> payloads;
+        payloads.reserve(legacy.size());
+        for (const TransactionRecord &r : legacy)
+            payloads.append(encodeRecord(r));
+        if (tmp.append(payloads) < 0) {
+            qWarning() << "History migration failed; keeping" << iniPath;
+            return;
+        }
+    }
+    if (!QFile::rename(tmpPath, journalPath())) return;
+    QFile::remove(iniPath + ".migrated");
+    QFile::rename(iniPath, iniPath + ".migrated");
+    qDebug() << "Migrated" << legacy.size() << "history records to" << journalPath();
+}
+
+static RecordJournal &journal()
+{
+    static RecordJournal j(journalPath());
+    if (!j.isOpen()) {
+        migrateLegacyIni();
+        j.open();
+    }
+    return j;
+}
+
+QList<TransactionRecord> TransactionHistory::load()
+{
+    return loadFrom(0, nullptr);
+}
+
+QList<TransactionRecord> TransactionHistory::loadFrom(qint64 offset, qint64 *nextOffset)
+{
+    QList<TransactionRecord> list;
+    const QList<QByteArray> payloads = journal().readFrom(offset, nextOffset);
+    list.reserve(payloads.size());
+    for (const QByteArray &payload : payloads) {
+        TransactionRecord r;
+        if (decodeRecord(payload, r))
+            list.append(r);
+    }
+    return list;
+}
+
+qint64 TransactionHistory::append(const TransactionRecord &record)
+{
+    qint64 end = journal().append(encodeRecord(record));
+    if (end < 0)
+        qWarning() << "Failed to append transaction" << record.id << "to history";
+    return end;
+}
+
+qint64 TransactionHistory::endOffset()
+{
+    return journal().endOffset();
 }
 
 void TransactionHistory::clear()
 {
-    QSettings s(historyPath(), QSettings::IniFormat);
-    s.remove("transactions");
+    journal().clear();
 }
@@ -8,7 +8,12 @@ class TransactionHistory
 {
 public:
     static QList<TransactionRecord> load();
-    static void append(const TransactionRecord &record);
+    // Incremental read: records appended at or after 'offset' (0 = start of history).
+    // 'nextOffset' receives the offset to pass on the next call.
+    static QList<TransactionRecord> loadFrom(qint64 offset, qint64 *nextOffset);
+    // Returns the history end offset after the append, or -1 on failure.
+    static qint64 append(const TransactionRecord &record);
+    static qint64 endOffset();
     static void clear();
 };
 
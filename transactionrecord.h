@@ -0,0 +1,20 @@
+#ifndef TRANSACTIONRECORD_H
+#define TRANSACTIONRECORD_H
+
+#include <QString>
+#include <QDateTime>
+#include "money.h"
+
+struct TransactionRecord {
+    QString id;
+    QString type;       // "online" | "offline"
+    QString role;       // "sender" | "receiver"
+    QString peerId;
+    Money amount;
+    QString amountText; // original text of an amount that did not parse (legacy records only)
+    QString nonce;      // timestamp (date + time)
+    QString status;     // "pending" | "completed" | "failed" | "frozen"
+    QDateTime createdAt;
+};
+
+#endif // TRANSACTIONRECORD_H
@@ -0,0 +1,75 @@
+#include "ultrasoundemitter.h"
+#include <algorithm>
+#include <cstring>
+
+UltrasoundEmitter::UltrasoundEmitter(const QAudioFormat &format, QObject *parent)
+    : QIODevice(parent)
+    , m_format(format)
+    , m_modulator(Ultrasound::ModemParams::forSampleRate(format.sampleRate()))
+{
+}
+
+bool UltrasoundEmitter::supportsFormat(const QAudioFormat &format)
+{
+    return Ultrasound::ModemParams::forSampleRate(format.sampleRate()).isValid()
+           && format.channelCount() > 0
+           && (format.sampleFormat() == QAudioFormat::Int16 || format.sampleFormat() == QAudioFormat::Float);
+}
+
+bool UltrasoundEmitter::setPayload(const QByteArray &payload, Ultrasound::Fec::CodeRate rate)
+{
+    return m_modulator.setPayload(reinterpret_cast<const unsigned char *>(payload.constData()),
+                                  size_t(payload.size()), true, rate);
+}
+
+qint64 UltrasoundEmitter::bytesAvailable() const
+{
+    // The frame repeats, so there is always another second of audio to read
+    return qint64(m_format.bytesForDuration(1000000)) + QIODevice::bytesAvailable();
+}
+
+qint64 UltrasoundEmitter::readData(char *data, qint64 maxSize)
+{
+    const int channels = m_format.channelCount();
+    const int bytesPerFrame = m_format.bytesPerFrame();
+    if (bytesPerFrame <= 0) return -1;
+    size_t frames = size_t(maxSize / bytesPerFrame);
+    const bool isFloat = m_format.sampleFormat() == QAudioFormat::Float;
+
+    if (channels == 1) {
+        // Synthesize directly into the sink's buffer
+        const size_t n = isFloat ? m_modulator.render(reinterpret_cast<float *>(data), frames)
+                                 : m_modulator.render(reinterpret_cast<int16_t *>(data), frames);
+        return qint64(n) * bytesPerFrame;
+    }
+
+    // Same signal on every channel: render mono in chunks and fan it out
+    float mono[256];
+    qint64 written = 0;
+    while (frames > 0) {
+        const size_t want = std::min(frames, sizeof(mono) / sizeof(mono[0]));
+        const size_t got = m_modulator.render(mono, want);
+        for (size_t i = 0; i < got; ++i) {
+            for (int c = 0; c < channels; ++c) {
+                if (isFloat) {
+                    std::memcpy(data + written, &mono[i], sizeof(float));
+                    written += qint64(sizeof(float));
+                } else {
+                    const qint16 s = qint16(qRound(mono[i] * 32767.0f));
+                    std::memcpy(data + written, &s, sizeof(s));
+                    written += qint64(sizeof(s));
+                }
+            }
+        }
+        frames -= got;
+        if (got < want) break;
+    }
+    return written;
+}
+
+qint64 UltrasoundEmitter::writeData(const char *data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
@@ -0,0 +1,35 @@
+#ifndef ULTRASOUNDEMITTER_H
+#define ULTRASOUNDEMITTER_H
+
+#include <QAudioFormat>
+#include <QByteArray>
+#include <QIODevice>
+#include "FskModem.h"
+
+// Pull-mode audio source for QAudioSink: each read() synthesizes the next stretch of the
+// FSK-modulated payload straight into the sink's buffer, in the sink's sample format
+// (Int16 or Float, any channel count). Nothing is allocated while streaming.
+class UltrasoundEmitter : public QIODevice
+{
+    Q_OBJECT
+public:
+    UltrasoundEmitter(const QAudioFormat &format, QObject *parent = nullptr);
+
+    static bool supportsFormat(const QAudioFormat &format);
+
+    bool setPayload(const QByteArray &payload, Ultrasound::Fec::CodeRate rate = Ultrasound::Fec::DEFAULT_RATE);
+    double frameSeconds() const { return m_modulator.frameSeconds(); }
+
+    bool isSequential() const override { return true; }
+    qint64 bytesAvailable() const override;
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    QAudioFormat m_format;
+    Ultrasound::FskModulator m_modulator;
+};
+
+#endif // ULTRASOUNDEMITTER_H
@@ -1,4 +1,7 @@
 #include "ultrasoundhelper.h"
+#include "ultrasoundemitter.h"
+#include "ultrasoundreceiver.h"
+#include "Ultrasound.h"
 #include <QDebug>
 
 #ifdef Q_OS_ANDROID
@@ -8,11 +11,13 @@
 
 UltrasoundHelper::UltrasoundHelper(QObject *parent) 
     : QObject(parent)
-    , m_audioSource(nullptr)
     , m_audioSink(nullptr)
-    , m_inputDevice(nullptr)
-    , m_outputDevice(nullptr)
+    , m_emitter(nullptr)
+    , m_receiver(new UltrasoundReceiver(this))
 {
+    // Queued: frames are decoded on the receiver's DSP thread
+    connect(m_receiver, &UltrasoundReceiver::frameDecoded, this, &UltrasoundHelper::onFrameDecoded,
+            Qt::QueuedConnection);
     setupAudio();
 }
 
@@ -112,24 +117,34 @@ void UltrasoundHelper::startEmitting(const QByteArray &payload)
     
     qDebug() << "Starting ultrasound emission with" << payload.size() << "bytes";
     
-    // Initialize audio output
+    // Initialize audio output; 18-22 kHz tones need a 44.1 kHz or faster stream
     QAudioDevice outputDevice = QMediaDevices::defaultAudioOutput();
-    m_audioSink = new QAudioSink(outputDevice, m_format, this);
-    
-    // TODO: Generate ultrasound signal from payload
-    // For now, this is a placeholder - actual implementation would:
-    // 1. Convert payload to ultrasound frequencies (18-22 kHz)
-    // 2. Generate audio waveform
-    // 3. Write to QIODevice from m_audioSink->start()
-    
-    m_outputDevice = m_audioSink->start();
-    if (!m_outputDevice) {
-        qWarning() << "Failed to start audio output";
+    QAudioFormat format = m_format;
+    if (!outputDevice.isFormatSupported(format) || !UltrasoundEmitter::supportsFormat(format))
+        format = outputDevice.preferredFormat();
+    if (!UltrasoundEmitter::supportsFormat(format)) {
+        qWarning() << "Audio output cannot carry near-ultrasound:" << format;
+        emit error(tr("This device's speaker output cannot play ultrasound."));
+        stopEmitting();
+        return;
+    }
+
+    // Pull mode: the sink asks the emitter for samples as it needs them
+    m_emitter = new UltrasoundEmitter(format, this);
+    if (!m_emitter->setPayload(payload) || !m_emitter->open(QIODevice::ReadOnly)) {
+        emit error(tr("Payload too large to emit."));
+        stopEmitting();
+        return;
+    }
+    m_audioSink = new QAudioSink(outputDevice, format, this);
+    m_audioSink->start(m_emitter);
+    if (m_audioSink->error() != QAudio::NoError) {
+        qWarning() << "Failed to start audio output" << m_audioSink->error();
         stopEmitting();
         return;
     }
     
-    qDebug() << "Ultrasound emission started";
+    qDebug() << "Ultrasound emission started," << m_emitter->frameSeconds() << "s per repetition";
 }
 
 void UltrasoundHelper::stopEmitting()
@@ -144,13 +159,17 @@ void UltrasoundHelper::stopEmitting()
         m_audioSink = nullptr;
     }
     
-    m_outputDevice = nullptr;
+    if (m_emitter) {
+        m_emitter->close();
+        m_emitter->deleteLater();
+        m_emitter = nullptr;
+    }
     m_emitPayload.clear();
     
     qDebug() << "Ultrasound emission stopped";
 }
 
-void UltrasoundHelper::startListening()
+void UltrasoundHelper::startListening(const QByteArray &header)
 {
     // Check permission first on Android
 #ifdef Q_OS_ANDROID
@@ -167,23 +186,23 @@ void UltrasoundHelper::startListening()
     }
     
     m_listening = true;
-    m_audioBuffer.clear();
+    m_frameHeader = header;
     
     qDebug() << "Starting ultrasound listening...";
     
-    // Initialize audio input
-    QAudioDevice inputDevice = QMediaDevices::defaultAudioInput();
-    m_audioSource = new QAudioSource(inputDevice, m_format, this);
-    
-    m_inputDevice = m_audioSource->start();
-    if (!m_inputDevice) {
-        qWarning() << "Failed to start audio input";
+    if (!UltrasoundReceiver::supportsFormat(m_format)) {
+        qWarning() << "Audio input cannot capture near-ultrasound:" << m_format;
+        emit error(tr("This device's microphone input cannot capture ultrasound."));
+        stopListening();
+        return;
+    }
+    // Capture and demodulation run on their own threads; the largest frame accepted is a header
+    // and a KEY_SIZE key, anything longer is noise that happened to look like a preamble
+    if (!m_receiver->start(QMediaDevices::defaultAudioInput(), m_format, qsizetype(Ultrasound::MAX_FRAME_SIZE))) {
+        emit error(tr("Could not start the microphone."));
         stopListening();
         return;
     }
-    
-    // Connect to read audio data as it arrives
-    connect(m_inputDevice, &QIODevice::readyRead, this, &UltrasoundHelper::onAudioDataReady);
     
     qDebug() << "Ultrasound listening started";
 }
@@ -194,48 +213,29 @@ void UltrasoundHelper::stopListening()
     
     m_listening = false;
     
-    if (m_inputDevice) {
-        disconnect(m_inputDevice, &QIODevice::readyRead, this, &UltrasoundHelper::onAudioDataReady);
-    }
-    
-    if (m_audioSource) {
-        m_audioSource->stop();
-        m_audioSource->deleteLater();
-        m_audioSource = nullptr;
-    }
-    
-    m_inputDevice = nullptr;
-    m_audioBuffer.clear();
+    m_receiver->stop();
     
     qDebug() << "Ultrasound listening stopped";
 }
 
-void UltrasoundHelper::onAudioDataReady()
+void UltrasoundHelper::onFrameDecoded(const QByteArray &frame)
 {
-    if (!m_inputDevice || !m_listening) return;
-    
-    // Read audio data from microphone
-    QByteArray chunk = m_inputDevice->readAll();
-    if (chunk.isEmpty()) return;
-    
-    m_audioBuffer.append(chunk);
-    
-    // TODO: Process audio buffer to detect ultrasound patterns
-    // For now, this is a placeholder - actual implementation would:
-    // 1. Apply FFT to detect 18-22 kHz frequencies
-    // 2. Decode the ultrasound signal back to data
-    // 3. Extract header and payload
-    // 4. Emit keyReceived signal when complete
-    
-    // Placeholder: simulate detection after collecting 2x expected size
-    const int expectedSize = 4096; // Adjust based on actual payload size
-    if (m_audioBuffer.size() >= expectedSize * 2) {
-        // Extract mock key (in real implementation, decode from audio)
-        QByteArray extractedKey = m_audioBuffer.left(32); // Placeholder
-        emit keyReceived(extractedKey);
-        
-        // Clear buffer after extraction
-        m_audioBuffer.clear();
-        qDebug() << "Ultrasound key extracted (placeholder)";
+    // A frame already queued when listening stopped
+    if (!m_listening) return;
+
+    // The frame is the emit payload: our header, then the key exactly as it was sent. The key
+    // may be binary, so it is taken by the framed length and never trimmed.
+    const auto bytes = [](const QByteArray &data) {
+        return ByteSpan(reinterpret_cast<const std::byte *>(data.constData()), size_t(data.size()));
+    };
+    const ByteSpan found = Ultrasound::keyInFrame(bytes(frame), bytes(m_frameHeader));
+    if (found.empty()) {
+        qWarning() << "Ignoring ultrasound frame without the expected header," << frame.size() << "bytes";
+        return;
     }
+    const QByteArray key(reinterpret_cast<const char *>(found.data()), qsizetype(found.size()));
+
+    qDebug() << "Ultrasound key decoded," << key.size() << "bytes";
+    stopListening();
+    emit keyReceived(key);
 }
@@ -3,12 +3,14 @@
 
 #include <QObject>
 #include <QByteArray>
-#include <QAudioSource>
 #include <QAudioSink>
 #include <QAudioFormat>
 #include <QMediaDevices>
 #include <QIODevice>
 
+class UltrasoundEmitter;
+class UltrasoundReceiver;
+
 class UltrasoundHelper : public QObject
 {
     Q_OBJECT
@@ -20,8 +22,9 @@ public:
     void startEmitting(const QByteArray &payload);
     void stopEmitting();
 
-    // Sender: start recording from mic, buffer size 2x; when enough data, search header and extract key
-    void startListening();
+    // Sender: start demodulating the mic; keyReceived fires as soon as a frame opening with
+    // header decodes
+    void startListening(const QByteArray &header);
     void stopListening();
     
     // Check and request audio permission (Android)
@@ -37,7 +40,7 @@ signals:
     void permissionRequired();
 
 private slots:
-    void onAudioDataReady();
+    void onFrameDecoded(const QByteArray &frame);
 
 private:
     void setupAudio();
@@ -46,13 +49,12 @@ private:
     bool m_listening = false;
     
     QAudioFormat m_format;
-    QAudioSource *m_audioSource;
     QAudioSink *m_audioSink;
-    QIODevice *m_inputDevice;
-    QIODevice *m_outputDevice;
+    UltrasoundEmitter *m_emitter;
+    UltrasoundReceiver *m_receiver;
     
     QByteArray m_emitPayload;
-    QByteArray m_audioBuffer;
+    QByteArray m_frameHeader;
 };
 
 #endif // ULTRASOUNDHELPER_H
@@ -0,0 +1,194 @@
+#include "ultrasoundreceiver.h"
+#include "FskModem.h"
+#include <QAudioSource>
+#include <QDebug>
+#include <QIODevice>
+#include <QThread>
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace {
+
+// Write end of the capture path: QAudioSource writes each captured block here on the capture
+// thread. The first channel is converted to float and pushed into the ring; the push never
+// blocks, so a late DSP thread costs samples (counted by the ring), never a stalled callback.
+class MicRingSink : public QIODevice
+{
+public:
+    MicRingSink(const QAudioFormat &format, SpscRing<float> &ring, std::atomic<quint64> &captured, QObject *parent)
+        : QIODevice(parent)
+        , m_format(format)
+        , m_ring(ring)
+        , m_captured(captured)
+    {
+        m_carry.reserve(format.bytesPerFrame());
+    }
+
+    bool isSequential() const override { return true; }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override
+    {
+        Q_UNUSED(data);
+        Q_UNUSED(maxSize);
+        return -1;
+    }
+
+    qint64 writeData(const char *data, qint64 size) override
+    {
+        const qint64 bytesPerFrame = m_format.bytesPerFrame();
+        const char *p = data;
+        qint64 left = size;
+        // Backends deliver whole frames, but a split one must not shift every later sample
+        if (!m_carry.isEmpty()) {
+            const qint64 need = std::min<qint64>(bytesPerFrame - m_carry.size(), left);
+            m_carry.append(p, need);
+            p += need;
+            left -= need;
+            if (m_carry.size() < bytesPerFrame) return size;
+            convert(m_carry.constData(), 1);
+            m_carry.clear();
+        }
+        const qint64 frames = left / bytesPerFrame;
+        convert(p, frames);
+        m_carry.append(p + frames * bytesPerFrame, left - frames * bytesPerFrame);
+        return size;
+    }
+
+private:
+    void convert(const char *data, qint64 frames)
+    {
+        const qint64 bytesPerFrame = m_format.bytesPerFrame();
+        const bool isFloat = m_format.sampleFormat() == QAudioFormat::Float;
+        float mono[256];
+        while (frames > 0) {
+            const qint64 n = std::min<qint64>(frames, qint64(std::size(mono)));
+            for (qint64 i = 0; i < n; ++i) {
+                const char *frame = data + i * bytesPerFrame;
+                if (isFloat) {
+                    std::memcpy(&mono[i], frame, sizeof(float));
+                } else {
+                    qint16 s;
+                    std::memcpy(&s, frame, sizeof(s));
+                    mono[i] = s * (1.0f / 32768.0f);
+                }
+            }
+            m_ring.push(mono, size_t(n));
+            m_captured.fetch_add(quint64(n), std::memory_order_relaxed);
+            data += n * bytesPerFrame;
+            frames -= n;
+        }
+    }
+
+    QAudioFormat m_format;
+    SpscRing<float> &m_ring;
+    std::atomic<quint64> &m_captured;
+    QByteArray m_carry;
+};
+
+} // namespace
+
+UltrasoundReceiver::UltrasoundReceiver(QObject *parent)
+    : QObject(parent)
+{
+}
+
+UltrasoundReceiver::~UltrasoundReceiver()
+{
+    stop();
+}
+
+bool UltrasoundReceiver::supportsFormat(const QAudioFormat &format)
+{
+    return Ultrasound::ModemParams::forSampleRate(format.sampleRate()).isValid()
+           && format.channelCount() > 0
+           && (format.sampleFormat() == QAudioFormat::Int16 || format.sampleFormat() == QAudioFormat::Float);
+}
+
+bool UltrasoundReceiver::start(const QAudioDevice &device, const QAudioFormat &format, qsizetype maxFrameSize)
+{
+    stop();
+    if (!supportsFormat(format)) return false;
+
+    // One second of slack between capture and DSP
+    m_ring = std::make_unique<SpscRing<float>>(size_t(format.sampleRate()));
+    m_demodulator = std::make_unique<Ultrasound::FskDemodulator>(
+        Ultrasound::ModemParams::forSampleRate(format.sampleRate()), size_t(maxFrameSize),
+        [this](const unsigned char *data, size_t size) {
+            // Emitted on the DSP thread; GUI-thread receivers get it queued
+            emit frameDecoded(QByteArray(reinterpret_cast<const char *>(data), qsizetype(size)));
+        });
+    m_captured = 0;
+    m_dspThread = std::thread([this]() { runDsp(); });
+
+    m_captureThread = new QThread(this);
+    m_captureThread->setObjectName(QStringLiteral("UltrasoundCapture"));
+    m_captureContext = new QObject;
+    m_captureContext->moveToThread(m_captureThread);
+    m_captureThread->start(QThread::TimeCriticalPriority);
+
+    bool started = false;
+    QMetaObject::invokeMethod(m_captureContext, [this, &device, &format, &started]() {
+        auto *sink = new MicRingSink(format, *m_ring, m_captured, m_captureContext);
+        sink->open(QIODevice::WriteOnly);
+        m_source = new QAudioSource(device, format, m_captureContext);
+        m_source->start(sink);
+        started = m_source->error() == QAudio::NoError;
+    }, Qt::BlockingQueuedConnection);
+
+    if (!started) {
+        qWarning() << "Failed to start audio input" << (m_source ? m_source->error() : QAudio::OpenError);
+        stop();
+        return false;
+    }
+    return true;
+}
+
+void UltrasoundReceiver::stop()
+{
+    if (m_captureThread) {
+        QMetaObject::invokeMethod(m_captureContext, [this]() {
+            if (m_source) {
+                m_source->stop();
+                delete m_source;
+                m_source = nullptr;
+            }
+        }, Qt::BlockingQueuedConnection);
+        m_captureThread->quit();
+        m_captureThread->wait();
+        // The thread has finished, so its objects may be deleted from here
+        delete m_captureContext;
+        m_captureContext = nullptr;
+        delete m_captureThread;
+        m_captureThread = nullptr;
+    }
+
+    if (m_dspThread.joinable()) {
+        m_ring->close();
+        m_dspThread.join();
+        qDebug() << "Ultrasound capture:" << capturedSamples() << "samples," << droppedSamples()
+                 << "dropped, peak backlog" << peakBacklog() << "of" << backlogCapacity();
+        // The DSP thread is gone, so the demodulator can be read from here
+        qDebug() << "Ultrasound frames:" << m_demodulator->framesDecoded() << "decoded,"
+                 << m_demodulator->framesDropped() << "dropped," << m_demodulator->bytesCorrected()
+                 << "bytes corrected";
+    }
+    m_demodulator.reset();
+}
+
+void UltrasoundReceiver::runDsp()
+{
+    float block[1024];
+    for (;;) {
+        const size_t n = m_ring->pop(block, std::size(block));
+        if (n > 0) {
+            m_demodulator->process(block, n);
+        } else if (m_ring->closed()) {
+            // No more pushes are coming; leave once the last of them is drained
+            if (m_ring->size() == 0) break;
+        } else {
+            m_ring->wait();
+        }
+    }
+}
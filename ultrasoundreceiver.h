@@ -0,0 +1,57 @@
+#ifndef ULTRASOUNDRECEIVER_H
+#define ULTRASOUNDRECEIVER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QAudioDevice>
+#include <QAudioFormat>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include "SpscRing.h"
+
+class QAudioSource;
+class QThread;
+namespace Ultrasound { class FskDemodulator; }
+
+// Mic capture and demodulation kept off the GUI thread. QAudioSource runs on its own capture
+// thread and hands every block to a sink that converts it to mono float and pushes it into a
+// lock-free ring; a dedicated DSP thread drains the ring through the FSK demodulator. Decoded
+// frames come back as frameDecoded(), which reaches GUI-thread receivers queued. A GUI stall
+// can no longer lose audio; if the DSP thread ever falls a full second behind, the samples
+// it missed are counted in droppedSamples().
+class UltrasoundReceiver : public QObject
+{
+    Q_OBJECT
+public:
+    explicit UltrasoundReceiver(QObject *parent = nullptr);
+    ~UltrasoundReceiver();
+
+    static bool supportsFormat(const QAudioFormat &format);
+
+    bool start(const QAudioDevice &device, const QAudioFormat &format, qsizetype maxFrameSize);
+    void stop();
+    bool isRunning() const { return m_captureThread != nullptr; }
+
+    quint64 capturedSamples() const { return m_captured.load(std::memory_order_relaxed); }
+    quint64 droppedSamples() const { return m_ring ? m_ring->overruns() : 0; }
+    // Most samples ever waiting for the DSP thread; near capacity means drops are close
+    qsizetype peakBacklog() const { return m_ring ? qsizetype(m_ring->highWater()) : 0; }
+    qsizetype backlogCapacity() const { return m_ring ? qsizetype(m_ring->capacity()) : 0; }
+
+signals:
+    void frameDecoded(const QByteArray &frame);
+
+private:
+    void runDsp();
+
+    QThread *m_captureThread = nullptr;
+    QObject *m_captureContext = nullptr;    // lives on m_captureThread, parents the sink
+    QAudioSource *m_source = nullptr;       // lives on m_captureThread
+    std::unique_ptr<SpscRing<float>> m_ring;
+    std::unique_ptr<Ultrasound::FskDemodulator> m_demodulator;     // used only by m_dspThread
+    std::thread m_dspThread;
+    std::atomic<quint64> m_captured{0};
+};
+
+#endif // ULTRASOUNDRECEIVER_H